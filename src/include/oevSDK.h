@@ -32,6 +32,8 @@
 
 #endif
 
+#include <stddef.h>
+
 struct gvCpuid
 {
 	char* Name;
@@ -57,6 +59,120 @@ struct gvCpuid
 	int Threads;
 };
 
+// Per-frame timings of a rendering test. Times are in milliseconds.
+struct gvFrameTimings
+{
+	int structSize;
+	int frameCount;
+	const float* frameTime; // Present to present
+	const float* cpuTime; // CPU submit
+	const float* gpuTime; // GPU timestamp queries, NULL if not supported
+	// Computed from frameTime
+	float minTime;
+	float maxTime;
+	float p50;
+	float p95;
+	float p99;
+	float low1; // 1% low, in fps
+};
+
+// GPU time of a render pass, from GL_TIMESTAMP queries or vkCmdWriteTimestamp
+struct gvPassTiming
+{
+	const char* name; // "shadow", "geometry", "resolve", ...
+	float gpuTime; // Average milliseconds per frame
+	float gpuTimeMax;
+};
+
+// CPU time of a WGLDIAG_OPTION_MPENGINE worker thread
+struct gvThreadTiming
+{
+	float cpuTime; // Average milliseconds per frame, from GetThreadTimes
+	float busy; // Fraction of the frame spent recording or uploading
+	int items; // Draws recorded or uploads done per frame
+	int steals; // Work items taken from another thread's queue per frame
+};
+
+// Throughput of one draw mode of OEV_SCENE_DRAWCALLS
+struct gvDrawModeStats
+{
+	int mode; // OEV_DRAW_*, 0 if not supported by the renderer (no measurement)
+	float drawsPerSecond; // Objects drawn per second
+	float cpuTime; // Milliseconds per frame on the submitting thread
+	float gpuTime; // Milliseconds per frame, 0 without timestamp queries
+	float fps;
+};
+
+// OEV_SCENE_STREAMING results. Times are in milliseconds.
+struct gvStreamingStats
+{
+	int structSize;
+	unsigned long long bytesUploaded;
+	float throughput; // Sustained GB/s over the measured time
+	float latencyMean; // Upload start to first frame sampling the texture
+	float latencyP99;
+	float latencyMax;
+	// Frame time standard deviation while streaming, and over the same scene without uploads;
+	// the difference is the jitter caused by uploads
+	float frameTimeJitter;
+	float idleFrameTimeJitter;
+	int stalls; // Frames that waited for a free staging buffer
+	int transferQueue; // 1 if uploads ran on a dedicated Vulkan transfer queue
+};
+
+// Hardware telemetry recorded during a test, 0 when a sensor is not available
+struct gvTelemetrySample
+{
+	float time; // Milliseconds since the start of the test
+	float cpuClock; // MHz
+	float gpuCoreClock; // MHz
+	float gpuMemoryClock; // MHz
+	float cpuTemperature; // Celsius
+	float gpuTemperature;
+	float cpuPower; // Watts
+	float gpuPower;
+};
+
+// How present-to-display latency was measured
+enum ovLatencySource
+{
+	LATENCY_NONE, // Not supported by the renderer, the driver or the presentation mode
+	LATENCY_VK_DISPLAY_TIMING, // VK_GOOGLE_display_timing, actual present time and refresh cycle
+	LATENCY_VK_PRESENT_WAIT, // VK_KHR_present_wait, completion time only
+	LATENCY_DXGI_FRAME_STATISTICS, // GL through a DXGI swapchain, IDXGISwapChain::GetFrameStatistics
+	LATENCY_OML_SYNC_CONTROL // wglGetSyncValuesOML, vblank counter sampled after SwapBuffers
+};
+
+// Presentation latency of a rendering test, WGLDIAG_OPTION_LATENCY. Times are in milliseconds.
+struct gvLatencyStats
+{
+	int structSize;
+	enum ovLatencySource source;
+	int presentCount;
+	const float* latency; // Per present, CPU submit to the start of scanout
+	float refreshInterval; // Display refresh period, 0 if unknown
+	float mean;
+	float p50;
+	float p95;
+	float p99;
+	float max;
+	float displayIntervalJitter; // Standard deviation of the time between two displayed frames
+	// Presents shown one or more refresh cycles after the vblank they targeted.
+	// Without vsync: refresh cycles that repeated the previous frame while a new one was queued.
+	int missedVblanks;
+};
+
+enum ovTestStatus
+{
+	TESTSTATUS_OK,
+	TESTSTATUS_FAILED,
+	TESTSTATUS_UNSUPPORTED, // Not runnable by the renderer or its driver
+	TESTSTATUS_CANCELLED // oevJobCancel
+};
+
+// Results of a run, strings and arrays included, are allocated from a single arena.
+// The list is also an array: result i is at OEV_RESULT_AT(head, i), next links are kept.
+// Release with oevFreeRenderingTestResults, except for oevJobGetResults which belongs to the job.
 struct gvRenderingTestResult
 {
 	int structSize;
@@ -65,8 +181,45 @@ struct gvRenderingTestResult
 	float fps;
 	const char* result;
 	struct gvRenderingTestResult* next;
+	// Extended fields, check with OEV_HAS_FIELD before access
+	const struct gvFrameTimings* frameTimings;
+	int configIndex; // Position of the configuration in a batch, or in a sweep product (first element varies slowest)
+	int adapter; // gvAdapter::index the test ran on
+	int passCount; // WGLDIAG_OPTION_PROFILE
+	const struct gvPassTiming* passes;
+	int cacheHits; // Pipelines and programs loaded from gvRenderingTestConfig::pipelineCache
+	int cacheMisses; // Compiled and stored
+	int warmupTime; // Milliseconds rendered before measurement started
+	int warmupSteady; // 0 if gvRenderingTestConfig::warmup elapsed before frame times settled
+	int sampleCount; // Measured frames
+	int measuredTime; // Measured milliseconds, less than duration if targetRse was reached
+	float achievedRse; // Relative standard error of the mean frame time
+	int telemetryCount; // gvRenderingTestConfig::telemetryInterval
+	const struct gvTelemetrySample* telemetry;
+	// Clocks dropped more than 10% below their peak while measuring,
+	// or the driver reported a thermal or power limit
+	int throttled;
+	enum ovTestStatus status; // Same as result, without string compares
+	int count; // Number of results in the list
+	const struct gvLatencyStats* latency; // WGLDIAG_OPTION_LATENCY, NULL if not requested
+	int threadCount; // gvRenderingTestConfig::workerThreads actually started
+	const struct gvThreadTiming* threads;
+	float submitCpuTime; // Context thread milliseconds per frame, with WGLDIAG_OPTION_MPENGINE: waiting and submission
+	int drawModeCount; // OEV_SCENE_DRAWCALLS, one entry per bit of gvRenderingTestConfig::drawModes
+	const struct gvDrawModeStats* drawModes;
+	const struct gvStreamingStats* streaming; // OEV_SCENE_STREAMING, NULL otherwise
+	int fbformat; // WGLDIAG_FB_* the test rendered to, varies with gvRenderingTestConfig::fbformatMask
+	int multisample; // Sample count, 0 without multisampling
 };
 
+// Result i of a list, the array stride is the structSize of the DLL
+#define OEV_RESULT_AT(head, i) \
+	((struct gvRenderingTestResult*)((char*)(head) + (size_t)(i) * (size_t)(head)->structSize))
+
+// Check if a struct returned by the SDK is recent enough to have a field
+#define OEV_HAS_FIELD(ptr, type, field) \
+	((ptr)->structSize >= (int)(offsetof(type, field) + sizeof(((type*)0)->field)))
+
 
 // Renderer list
 enum ovRenderer
@@ -95,6 +248,12 @@ enum ovRenderer
 #define WGLDIAG_FB_sRGB 1
 #define WGLDIAG_FB_HDR 2
 
+// gvRenderingTestConfig::fbformatMask
+#define OEV_FBFORMAT_BIT(fbformat) (1UL << (fbformat))
+#define OEV_FBFORMAT_ALL (OEV_FBFORMAT_BIT(WGLDIAG_FB_LINEAR) | OEV_FBFORMAT_BIT(WGLDIAG_FB_sRGB) | OEV_FBFORMAT_BIT(WGLDIAG_FB_HDR))
+// gvRenderingTestConfig::multisampleMask, sample counts or'ed together, 1 is no multisampling
+#define OEV_MULTISAMPLE_ALL (1 | 2 | 4 | 8 | 16)
+
 // Options 
 #define WGLDIAG_OPTION_ANISO 1
 #define WGLDIAG_OPTION_MULTISAMPLE (1UL<<1)
@@ -115,11 +274,200 @@ enum ovRenderer
 #define WGLDIAG_OPTION_VBUM (1UL<<18)
 #define WGLDIAG_OPTIONS_FS_EX (1UL << 19)
 #define WGLDIAG_OPTION_DEBUG (1UL << 20)
+// No window or surface: Vulkan without swapchain, GL pbuffer or EGL device.
+// Renders width x height into offscreen targets, display mode and fullscreen are ignored.
+// Usable from a service or a remote session.
+#define WGLDIAG_OPTION_HEADLESS (1UL << 21)
+// Timestamp queries around each render pass, see gvRenderingTestResult::passes
+#define WGLDIAG_OPTION_PROFILE (1UL << 22)
+// Measure present-to-display latency and missed vblanks, see gvRenderingTestResult::latency.
+// Timing queries add a little CPU work per frame, fps is slightly lower than without.
+#define WGLDIAG_OPTION_LATENCY (1UL << 23)
+
+// Procedural scenes start at 256, lower values select the scenes of GLVIEW.RMX.
+// API overhead test: objectCount small meshes, each with its own transform and material,
+// drawn once per draw mode of the drawModes mask. The test duration is split between the modes.
+#define OEV_SCENE_DRAWCALLS 256
 
+// Texture streaming test: mip chains of the GLVIEW.RMX textures are uploaded continuously
+// through a pool of streamBudget MB of staging buffers, persistent mapped PBOs on GL and a
+// dedicated transfer queue on Vulkan when the device has one. Each texture is sampled by the
+// frame following its upload. See gvRenderingTestResult::streaming.
+#define OEV_SCENE_STREAMING 257
+
+// Draw modes, the same workload submitted differently
+#define OEV_DRAW_INDIVIDUAL 1 // One draw call per object, glDrawElements / vkCmdDrawIndexed
+#define OEV_DRAW_INSTANCED (1UL<<1) // One instanced draw per mesh, per object data in a buffer
+#define OEV_DRAW_MULTI_INDIRECT (1UL<<2) // glMultiDrawElementsIndirect / vkCmdDrawIndexedIndirect
+#define OEV_DRAW_BINDLESS (1UL<<3) // GL_NV_vertex_buffer_unified_memory and bindless textures, Vulkan buffer device address
+// 0 selects OEV_DRAW_INDIVIDUAL, plus OEV_DRAW_INSTANCED with WGLDIAG_OPTION_INSTANCING
+// and OEV_DRAW_BINDLESS with WGLDIAG_OPTION_VBUM
+#define OEV_DRAW_ALL (OEV_DRAW_INDIVIDUAL | OEV_DRAW_INSTANCED | OEV_DRAW_MULTI_INDIRECT | OEV_DRAW_BINDLESS)
+
+// Typed rendering test configuration, same settings as the XML payload elements
+struct gvRenderingTestConfig
+{
+	int structSize;
+	enum ovRenderer renderer;
+	int option; // WGLDIAG_OPTION_*
+	int fbformat; // WGLDIAG_FB_*
+	int duration; // Seconds, maximum duration if targetRse is set
+	int multisample; // Sample count, 0 to disable
+	int anisotropy;
+	int textureLod;
+	int displayMode; // EnumDisplaySettings mode index, ignored with WGLDIAG_OPTION_HEADLESS
+	int pixelFormat;
+	int scene;
+	int width;
+	int height;
+	const char* tests; // ';' separated test list, NULL for all tests of the renderer
+	const char* fbenable; // NULL for "Default"
+	int adapter; // gvAdapter::index, 0 is the default adapter
+	// Directory of the VkPipelineCache / glGetProgramBinary cache, NULL to compile everything.
+	// Entries are keyed by driver version, renderer and pipeline state.
+	const char* pipelineCache;
+	// Warm-up: frames are rendered but not measured until the frame time of the last
+	// warmupWindow frames varies less than warmupTolerance (relative standard deviation),
+	// or warmup milliseconds elapsed. 0 to measure from the first frame.
+	int warmup;
+	float warmupTolerance; // 0 for 0.05
+	int warmupWindow; // 0 for 60 frames
+	// Adaptive duration: stop a test once the relative standard error of the mean frame time,
+	// computed over batch means to account for autocorrelation, is below targetRse. 0 runs duration.
+	float targetRse;
+	int minDuration; // Milliseconds measured before targetRse is checked
+	// Sample CPU / GPU clocks, temperatures and power from a background thread
+	// every telemetryInterval milliseconds, 0 to disable
+	int telemetryInterval;
+	// WGLDIAG_OPTION_MPENGINE worker threads, 0 for the engine default.
+	// Vulkan: threads record secondary command buffers, per-object draws are work-stolen.
+	// GL: shared contexts upload buffers and textures, draws stay on the context thread.
+	int workerThreads;
+	int objectCount; // OEV_SCENE_DRAWCALLS objects, 0 for 10000
+	int drawModes; // OEV_DRAW_* mask for OEV_SCENE_DRAWCALLS
+	int streamBudget; // OEV_SCENE_STREAMING staging pool in MB, 0 for 256
+	int streamQueueDepth; // OEV_SCENE_STREAMING uploads in flight, 0 for 4
+	// Format cycle: each test runs once per format of fbformatMask and sample count of
+	// multisampleMask without leaving the session. The context and swapchain are created once,
+	// rendering goes to offscreen targets created per combination, kept across the tests and
+	// blitted to the swapchain. Results are ordered by format, sample count, then test, and
+	// combinations the device cannot render are reported TESTSTATUS_UNSUPPORTED.
+	// 0 uses fbformat, respectively multisample.
+	int fbformatMask; // OEV_FBFORMAT_BIT(WGLDIAG_FB_*) or OEV_FBFORMAT_ALL
+	int multisampleMask; // Sample counts or'ed together or OEV_MULTISAMPLE_ALL
+};
+
+
+// Asynchronous rendering tests
+struct gvRenderingJob;
+
+enum ovJobStatus
+{
+	JOB_RUNNING,
+	JOB_COMPLETED,
+	JOB_CANCELLED,
+	JOB_FAILED
+};
+
+// Physical device, as listed by oevEnumAdapters
+struct gvAdapter
+{
+	int structSize;
+	int index; // 0 is the default adapter
+	char name[128];
+	unsigned int vendorId;
+	unsigned int deviceId;
+	unsigned long luidLowPart; // DXGI / WGL adapter LUID
+	long luidHighPart;
+	int vkPhysicalDevice; // Vulkan physical device index, -1 if the adapter has no Vulkan driver
+	unsigned long long dedicatedVideoMemory;
+};
+
+// WAD loading flags
+#define OEV_WAD_MAPPED 1 // Memory map the package instead of reading it
+#define OEV_WAD_LAZY (1UL<<1) // Decode textures and meshes when a scene first uses them
+
+struct gvWadStats
+{
+	int structSize;
+	int flags;
+	int entryCount;
+	int entriesDecoded;
+	unsigned long long fileBytes;
+	unsigned long long bytesPagedIn; // Mapped bytes actually touched
+	unsigned long long bytesDecoded;
+};
+
+// Immutable capabilities of a renderer: version strings, hashed extension set and limits.
+// Reference counted and safe to share between threads.
+struct gvCapabilities;
+
+// oevScanAllRenderers flags
+#define OEV_SCAN_DEBUG 1 // Debug contexts
+#define OEV_SCAN_SERIAL (1UL<<1) // One renderer at a time, for drivers failing concurrent context creation
+
+// Session: WAD package, renderer contexts and pipelines kept alive between runs
+struct gvSession;
+
+// oevTraceEnable flags
+#define OEV_TRACE_RING 1 // Record into a ring buffer read with oevTraceGetEvents
+#define OEV_TRACE_ETW (1UL<<1) // "RealtechVR.GLView" TraceLogging provider, events are only written while a session listens
+
+// Scoped marker: WAD load, context creation, shader compile, warm-up, measured frames, teardown...
+struct gvTraceEvent
+{
+	const char* name; // Static string, valid until infogl.dll is unloaded
+	const char* category; // "wad", "context", "shader", "warmup", "frames", "teardown"
+	long long start; // Microseconds on the QueryPerformanceCounter clock, comparable between processes
+	long long duration; // Microseconds
+	unsigned long threadId;
+	int arg; // Test index, frame count or shader count, -1 if none
+};
+
+// Called from the SDK worker thread each time a test finishes
+typedef void (*PFNOEVRENDERINGTESTCALLBACK)(const struct gvRenderingTestResult* result, void* userData);
 
 typedef int (*PFNOEVREADCPUID)(struct gvCpuid*);
 typedef int (*PFNOEVINITWAD)(const char*);
 typedef struct gvRenderingTestResult* (*PNFNOEVRUNRENDERINGTESTS)(const char*);
+typedef struct gvRenderingJob* (*PFNOEVRUNRENDERINGTESTSASYNC)(const char*, PFNOEVRENDERINGTESTCALLBACK, void*);
+typedef enum ovJobStatus (*PFNOEVJOBPOLL)(struct gvRenderingJob*);
+typedef enum ovJobStatus (*PFNOEVJOBWAIT)(struct gvRenderingJob*, int);
+typedef void (*PFNOEVJOBCANCEL)(struct gvRenderingJob*);
+typedef struct gvRenderingTestResult* (*PFNOEVJOBGETRESULTS)(struct gvRenderingJob*);
+typedef void (*PFNOEVJOBRELEASE)(struct gvRenderingJob*);
+typedef struct gvSession* (*PFNOEVSESSIONCREATE)(const char*);
+typedef struct gvRenderingTestResult* (*PFNOEVSESSIONRUN)(struct gvSession*, const char*);
+typedef struct gvRenderingJob* (*PFNOEVSESSIONRUNASYNC)(struct gvSession*, const char*, PFNOEVRENDERINGTESTCALLBACK, void*);
+typedef void (*PFNOEVSESSIONDESTROY)(struct gvSession*);
+typedef int (*PFNOEVINITWADEX)(const char*, int);
+typedef struct gvSession* (*PFNOEVSESSIONCREATEEX)(const char*, int);
+typedef int (*PFNOEVGETWADSTATS)(struct gvSession*, struct gvWadStats*);
+typedef struct gvRenderingTestResult* (*PFNOEVRUNRENDERINGTESTSEX)(const struct gvRenderingTestConfig*, int);
+typedef struct gvRenderingTestResult* (*PFNOEVSESSIONRUNEX)(struct gvSession*, const struct gvRenderingTestConfig*, int);
+typedef struct gvRenderingJob* (*PFNOEVSESSIONRUNASYNCEX)(struct gvSession*, const struct gvRenderingTestConfig*, int, PFNOEVRENDERINGTESTCALLBACK, void*);
+typedef int (*PFNOEVENUMADAPTERS)(struct gvAdapter*, int);
+typedef int (*PFNOEVSCANRENDERER)(enum ovRenderer, int);
+typedef const char* (*PFNOEVDIAGGETVERSION)(enum ovRenderer);
+typedef const char* (*PFNOEVDIAGGETRENDERERNAME)(enum ovRenderer);
+typedef const char* (*PFNOEVDIAGGETVENDORNAME)(enum ovRenderer);
+typedef int (*PFNOEVDIAGHASEXTENSION)(enum ovRenderer, const char*, ...);
+typedef const struct gvCapabilities* (*PFNOEVSCANRENDERERSNAPSHOT)(enum ovRenderer, int);
+typedef const struct gvCapabilities* (*PFNOEVSCANRENDERERSNAPSHOTEX)(enum ovRenderer, int, int);
+typedef const struct gvCapabilities* (*PFNOEVCAPSLOAD)(const char*);
+typedef int (*PFNOEVCAPSSAVE)(const struct gvCapabilities*, const char*);
+typedef void (*PFNOEVCAPSADDREF)(const struct gvCapabilities*);
+typedef void (*PFNOEVCAPSRELEASE)(const struct gvCapabilities*);
+typedef enum ovRenderer (*PFNOEVCAPSGETRENDERER)(const struct gvCapabilities*);
+typedef const char* (*PFNOEVCAPSGETVERSION)(const struct gvCapabilities*);
+typedef int (*PFNOEVCAPSHASEXTENSION)(const struct gvCapabilities*, const char*);
+typedef int (*PFNOEVCAPSGETLIMIT)(const struct gvCapabilities*, const char*, long long*);
+typedef const char* (*PFNOEVCAPSGETRENDERERNAME)(const struct gvCapabilities*);
+typedef const char* (*PFNOEVCAPSGETVENDORNAME)(const struct gvCapabilities*);
+typedef int (*PFNOEVSCANALLRENDERERS)(const struct gvCapabilities**, int, int);
+typedef void (*PFNOEVFREERENDERINGTESTRESULTS)(struct gvRenderingTestResult*);
+typedef int (*PFNOEVTRACEENABLE)(int, int);
+typedef int (*PFNOEVTRACEGETEVENTS)(struct gvTraceEvent*, int);
 
 
 #ifdef __cplusplus
@@ -142,15 +490,735 @@ extern "C" {
 	// Rescan viewer information. Must be called before access oevDiagGetVersion
 	_OEV_EXPORTFUNC int oevScanRenderer(enum ovRenderer renderer, int debugMode);
 
+	// Scan a renderer into a new snapshot, NULL if the renderer is not available. Release with oevCapsRelease
+	_OEV_EXPORTFUNC const struct gvCapabilities* oevScanRendererSnapshot(enum ovRenderer renderer, int debugMode);
+
+	// Same on the gvAdapter::index adapter, oevScanRendererSnapshot scans the default adapter
+	_OEV_EXPORTFUNC const struct gvCapabilities* oevScanRendererSnapshotEx(enum ovRenderer renderer, int adapter, int debugMode);
+
+	// Scan renderers 0 to count - 1 into caps[renderer], NULL when not available. GL and Vulkan
+	// are probed concurrently, version level queries share one context per API family.
+	// flags is OEV_SCAN_*. Returns the number of available renderers
+	_OEV_EXPORTFUNC int oevScanAllRenderers(const struct gvCapabilities** caps, int count, int flags);
+
+	// Load a snapshot saved by oevCapsSave. NULL if missing, or if the display driver changed since
+	_OEV_EXPORTFUNC const struct gvCapabilities* oevCapsLoad(const char* path);
+	_OEV_EXPORTFUNC int oevCapsSave(const struct gvCapabilities* caps, const char* path);
+
+	_OEV_EXPORTFUNC void oevCapsAddRef(const struct gvCapabilities* caps);
+	_OEV_EXPORTFUNC void oevCapsRelease(const struct gvCapabilities* caps);
+
+	_OEV_EXPORTFUNC enum ovRenderer oevCapsGetRenderer(const struct gvCapabilities* caps);
+	_OEV_EXPORTFUNC const char* oevCapsGetVersion(const struct gvCapabilities* caps);
+	_OEV_EXPORTFUNC const char* oevCapsGetRendererName(const struct gvCapabilities* caps);
+	_OEV_EXPORTFUNC const char* oevCapsGetVendorName(const struct gvCapabilities* caps);
+
+	// Constant time extension lookup, name is not a format string
+	_OEV_EXPORTFUNC int oevCapsHasExtension(const struct gvCapabilities* caps, const char* name);
+	_OEV_EXPORTFUNC int oevCapsGetExtensionCount(const struct gvCapabilities* caps);
+	_OEV_EXPORTFUNC const char* oevCapsGetExtension(const struct gvCapabilities* caps, int index);
+
+	// Limit by its API name ("GL_MAX_TEXTURE_SIZE", "maxImageDimension2D"). Returns 0 if unknown
+	_OEV_EXPORTFUNC int oevCapsGetLimit(const struct gvCapabilities* caps, const char* name, long long* value);
+
+	// Run rendering tests. szXml holds one configuration
+	//   <root><renderer>12</renderer><test>1.0</test>...</root>
+	// or a batch of configurations
+	//   <root><config>...</config><config>...</config></root>
+	// or a sweep, the cartesian product of the ';' separated values of each element but <test>
+	//   <root><sweep><multisample>0;4;8</multisample><fbformat>Linear;sRGB</fbformat>...</sweep></root>
+	// Batch configurations run grouped by renderer, display mode and framebuffer format
+	// to share contexts and swapchains, <sort>0</sort> keeps the payload order.
 	_OEV_EXPORTFUNC struct gvRenderingTestResult* oevRunRenderingTests(const char* szXml);
 
+	// Run rendering tests from count typed configurations, count > 1 runs a batch. structSize must be set
+	_OEV_EXPORTFUNC struct gvRenderingTestResult* oevRunRenderingTestsEx(const struct gvRenderingTestConfig* configs, int count);
+
+	// Release the results of oevRunRenderingTests, oevRunRenderingTestsEx, oevSessionRun and oevSessionRunEx
+	_OEV_EXPORTFUNC void oevFreeRenderingTestResults(struct gvRenderingTestResult* results);
+
+	// Start rendering tests on a worker thread and return immediately, the payload is copied. callback can be NULL
+	_OEV_EXPORTFUNC struct gvRenderingJob* oevRunRenderingTestsAsync(const char* szXml, PFNOEVRENDERINGTESTCALLBACK callback, void* userData);
+
+	// Get job status without blocking
+	_OEV_EXPORTFUNC enum ovJobStatus oevJobPoll(struct gvRenderingJob* job);
+
+	// Wait for job completion, timeoutMs < 0 waits forever. Returns JOB_RUNNING on timeout
+	_OEV_EXPORTFUNC enum ovJobStatus oevJobWait(struct gvRenderingJob* job, int timeoutMs);
+
+	// Request cancellation. The running test stops at the next frame, remaining tests are skipped
+	_OEV_EXPORTFUNC void oevJobCancel(struct gvRenderingJob* job);
+
+	// Results of the tests finished so far, valid until oevJobRelease
+	_OEV_EXPORTFUNC struct gvRenderingTestResult* oevJobGetResults(struct gvRenderingJob* job);
+
+	// Release job. A running job is cancelled and waited for
+	_OEV_EXPORTFUNC void oevJobRelease(struct gvRenderingJob* job);
+
+	// Create a session and load the WAD package once. Returns NULL on failure
+	_OEV_EXPORTFUNC struct gvSession* oevSessionCreate(const char* wadPath);
+
+	// Create a session with OEV_WAD_* flags
+	_OEV_EXPORTFUNC struct gvSession* oevSessionCreateEx(const char* wadPath, int wadFlags);
+
+	// Run rendering tests, reusing the session state
+	_OEV_EXPORTFUNC struct gvRenderingTestResult* oevSessionRun(struct gvSession* session, const char* szXml);
+
+	// Asynchronous version of oevSessionRun. Only one job can run per session
+	_OEV_EXPORTFUNC struct gvRenderingJob* oevSessionRunAsync(struct gvSession* session, const char* szXml, PFNOEVRENDERINGTESTCALLBACK callback, void* userData);
+
+	// Typed configuration versions of oevSessionRun and oevSessionRunAsync
+	_OEV_EXPORTFUNC struct gvRenderingTestResult* oevSessionRunEx(struct gvSession* session, const struct gvRenderingTestConfig* configs, int count);
+	_OEV_EXPORTFUNC struct gvRenderingJob* oevSessionRunAsyncEx(struct gvSession* session, const struct gvRenderingTestConfig* configs, int count, PFNOEVRENDERINGTESTCALLBACK callback, void* userData);
+
+	// Release the session. Jobs of the session must be released before
+	_OEV_EXPORTFUNC void oevSessionDestroy(struct gvSession* session);
+
 	// Wad
 	_OEV_EXPORTFUNC int oevInitWad(const char* path);
 
+	// Load WAD package with OEV_WAD_* flags
+	_OEV_EXPORTFUNC int oevInitWadEx(const char* path, int flags);
+
+	// Get package loading statistics of a session, or of oevInitWad if session is NULL. stats->structSize must be set
+	_OEV_EXPORTFUNC int oevGetWadStats(struct gvSession* session, struct gvWadStats* stats);
+
+	// Start or stop recording trace markers, flags is OEV_TRACE_*, 0 to disable. capacity is the
+	// number of events kept by OEV_TRACE_RING, oldest first out, 0 for 65536. Disabled markers cost
+	// one relaxed atomic load. Returns the previous flags
+	_OEV_EXPORTFUNC int oevTraceEnable(int flags, int capacity);
+
+	// Move up to maxCount of the recorded events into events, oldest first. Events not read stay
+	// in the ring. Returns the number of events copied
+	_OEV_EXPORTFUNC int oevTraceGetEvents(struct gvTraceEvent* events, int maxCount);
+
 	// Cpuid
 	_OEV_EXPORTFUNC void oevReadCpuid(struct gvCpuid* pxSystemCaps);
 
+	// List up to maxCount adapters, structSize of each element must be set. Returns the adapter count.
+	// Sessions targeting different adapters can run concurrently from different threads.
+	_OEV_EXPORTFUNC int oevEnumAdapters(struct gvAdapter* adapters, int maxCount);
+
+
+#ifdef __cplusplus
+}
+#endif
 
 #ifdef __cplusplus
+// Built-in rendering tests
+struct gvRenderingTestDesc
+{
+	const char* id; // Value for <test>
+	int version; // API version tested, major * 10 + minor
+	enum ovRenderer minRenderer; // First renderer able to run the test
+	enum ovRenderer maxRenderer; // Last renderer of the API family
+	const char* extension; // Runs on an older driver version if exposed, NULL if none
+};
+
+static constexpr struct gvRenderingTestDesc oevRenderingTests[] =
+{
+	{ "1.1", 11, RENDERER_GDI, RENDERER_GL2_0, NULL },
+	{ "1.2", 12, RENDERER_GL2_0, RENDERER_GL2_0, "GL_EXT_texture3D" },
+	{ "1.3", 13, RENDERER_GL2_0, RENDERER_GL2_0, "GL_ARB_multitexture" },
+	{ "1.5", 15, RENDERER_GL2_0, RENDERER_GL2_0, "GL_ARB_vertex_buffer_object" },
+	{ "2.0", 20, RENDERER_GL2_0, RENDERER_GL2_0, "GL_ARB_shading_language_100" },
+	{ "3.0", 30, RENDERER_GL3_0, RENDERER_GL4_6, "GL_ARB_framebuffer_object" },
+	{ "3.1", 31, RENDERER_GL3_1, RENDERER_GL4_6, "GL_ARB_uniform_buffer_object" },
+	{ "3.2", 32, RENDERER_GL3_2, RENDERER_GL4_6, "GL_ARB_geometry_shader4" },
+	{ "3.3", 33, RENDERER_GL3_3, RENDERER_GL4_6, "GL_ARB_instanced_arrays" },
+	{ "4.0", 40, RENDERER_GL4_0, RENDERER_GL4_6, "GL_ARB_tessellation_shader" },
+	{ "4.1", 41, RENDERER_GL4_1, RENDERER_GL4_6, "GL_ARB_viewport_array" },
+	{ "4.2", 42, RENDERER_GL4_2, RENDERER_GL4_6, "GL_ARB_shader_image_load_store" },
+	{ "4.3", 43, RENDERER_GL4_3, RENDERER_GL4_6, "GL_ARB_compute_shader" },
+	{ "4.4", 44, RENDERER_GL4_4, RENDERER_GL4_6, "GL_ARB_buffer_storage" },
+	{ "4.5", 45, RENDERER_GL4_5, RENDERER_GL4_6, "GL_ARB_direct_state_access" },
+	{ "1.0", 10, RENDERER_VK1_0, RENDERER_VK1_2, NULL },
+};
+
+static constexpr int oevRenderingTestCount = (int)(sizeof(oevRenderingTests) / sizeof(oevRenderingTests[0]));
+
+// Check if a renderer can run a built-in test, at compile time
+static constexpr bool oevIsTestSupported(int test, enum ovRenderer renderer)
+{
+	return renderer >= oevRenderingTests[test].minRenderer && renderer <= oevRenderingTests[test].maxRenderer;
 }
+
+static constexpr int oevGetTestCount(enum ovRenderer renderer, int test = 0)
+{
+	return test >= oevRenderingTestCount ? 0 : (oevIsTestSupported(test, renderer) ? 1 : 0) + oevGetTestCount(renderer, test + 1);
+}
+
+static_assert(oevGetTestCount(RENDERER_GDI) == 1, "GDI runs 1.1 only");
+static_assert(oevGetTestCount(RENDERER_GL3_0) == 1, "GL3.0 runs 3.0 only");
+static_assert(oevGetTestCount(RENDERER_GL4_6) == 10, "GL4.6 runs 3.0 to 4.5");
+static_assert(oevGetTestCount(RENDERER_VK1_2) == 1, "Vulkan runs 1.0");
+
+// Test passed, from status or from the result string of older infogl.dll builds
+inline bool oevIsTestPassed(const struct gvRenderingTestResult* result)
+{
+	if (OEV_HAS_FIELD(result, gvRenderingTestResult, status))
+	{
+		return result->status == TESTSTATUS_OK;
+	}
+	return result->result && result->result[0] == 'O' && result->result[1] == 'K' && result->result[2] == 0;
+}
+#endif
+
+#if defined(__cplusplus) && defined(_WIN32) && !defined(INFOGL_EXPORTS)
+#include <string>
+#include <stdlib.h>
+#include <vector>
+#include <unordered_map>
+
+// Load infogl.dll, resolve its entry points and open a session once per process.
+// Falls back to oevInitWad / oevRunRenderingTests with an infogl.dll without sessions.
+// traceFlags (OEV_TRACE_*) is set before the package is loaded, to trace the WAD loading too.
+class oevSession
+{
+public:
+	explicit oevSession(const char* wadPath = "GLVIEW.RMX", int wadFlags = 0, const char* dllPath = "infogl.dll", int traceFlags = 0)
+	{
+		library = LoadLibraryA(dllPath);
+		if (library == NULL)
+		{
+			return;
+		}
+		funcReadCpuid = GetProc<PFNOEVREADCPUID>("oevReadCpuid");
+		funcInitWad = GetProc<PFNOEVINITWAD>("oevInitWad");
+		funcRunRenderingTests = GetProc<PNFNOEVRUNRENDERINGTESTS>("oevRunRenderingTests");
+		funcRunRenderingTestsAsync = GetProc<PFNOEVRUNRENDERINGTESTSASYNC>("oevRunRenderingTestsAsync");
+		funcJobPoll = GetProc<PFNOEVJOBPOLL>("oevJobPoll");
+		funcJobWait = GetProc<PFNOEVJOBWAIT>("oevJobWait");
+		funcJobCancel = GetProc<PFNOEVJOBCANCEL>("oevJobCancel");
+		funcJobGetResults = GetProc<PFNOEVJOBGETRESULTS>("oevJobGetResults");
+		funcJobRelease = GetProc<PFNOEVJOBRELEASE>("oevJobRelease");
+		funcSessionCreate = GetProc<PFNOEVSESSIONCREATE>("oevSessionCreate");
+		funcSessionRun = GetProc<PFNOEVSESSIONRUN>("oevSessionRun");
+		funcSessionRunAsync = GetProc<PFNOEVSESSIONRUNASYNC>("oevSessionRunAsync");
+		funcSessionDestroy = GetProc<PFNOEVSESSIONDESTROY>("oevSessionDestroy");
+		funcInitWadEx = GetProc<PFNOEVINITWADEX>("oevInitWadEx");
+		funcSessionCreateEx = GetProc<PFNOEVSESSIONCREATEEX>("oevSessionCreateEx");
+		funcGetWadStats = GetProc<PFNOEVGETWADSTATS>("oevGetWadStats");
+		funcRunRenderingTestsEx = GetProc<PFNOEVRUNRENDERINGTESTSEX>("oevRunRenderingTestsEx");
+		funcSessionRunEx = GetProc<PFNOEVSESSIONRUNEX>("oevSessionRunEx");
+		funcSessionRunAsyncEx = GetProc<PFNOEVSESSIONRUNASYNCEX>("oevSessionRunAsyncEx");
+		funcEnumAdapters = GetProc<PFNOEVENUMADAPTERS>("oevEnumAdapters");
+		funcScanRenderer = GetProc<PFNOEVSCANRENDERER>("oevScanRenderer");
+		funcDiagGetVersion = GetProc<PFNOEVDIAGGETVERSION>("oevDiagGetVersion");
+		funcDiagGetRendererName = GetProc<PFNOEVDIAGGETRENDERERNAME>("oevDiagGetRendererName");
+		funcDiagGetVendorName = GetProc<PFNOEVDIAGGETVENDORNAME>("oevDiagGetVendorName");
+		funcDiagHasExtension = GetProc<PFNOEVDIAGHASEXTENSION>("oevDiagHasExtension");
+		funcScanRendererSnapshot = GetProc<PFNOEVSCANRENDERERSNAPSHOT>("oevScanRendererSnapshot");
+		funcScanRendererSnapshotEx = GetProc<PFNOEVSCANRENDERERSNAPSHOTEX>("oevScanRendererSnapshotEx");
+		funcCapsLoad = GetProc<PFNOEVCAPSLOAD>("oevCapsLoad");
+		funcCapsSave = GetProc<PFNOEVCAPSSAVE>("oevCapsSave");
+		funcCapsRelease = GetProc<PFNOEVCAPSRELEASE>("oevCapsRelease");
+		funcCapsGetRenderer = GetProc<PFNOEVCAPSGETRENDERER>("oevCapsGetRenderer");
+		funcCapsGetVersion = GetProc<PFNOEVCAPSGETVERSION>("oevCapsGetVersion");
+		funcCapsHasExtension = GetProc<PFNOEVCAPSHASEXTENSION>("oevCapsHasExtension");
+		funcCapsGetLimit = GetProc<PFNOEVCAPSGETLIMIT>("oevCapsGetLimit");
+		funcCapsGetRendererName = GetProc<PFNOEVCAPSGETRENDERERNAME>("oevCapsGetRendererName");
+		funcCapsGetVendorName = GetProc<PFNOEVCAPSGETVENDORNAME>("oevCapsGetVendorName");
+		funcScanAllRenderers = GetProc<PFNOEVSCANALLRENDERERS>("oevScanAllRenderers");
+		funcFreeRenderingTestResults = GetProc<PFNOEVFREERENDERINGTESTRESULTS>("oevFreeRenderingTestResults");
+		funcTraceEnable = GetProc<PFNOEVTRACEENABLE>("oevTraceEnable");
+		funcTraceGetEvents = GetProc<PFNOEVTRACEGETEVENTS>("oevTraceGetEvents");
+		if (traceFlags)
+		{
+			EnableTrace(traceFlags);
+		}
+		if (funcSessionCreateEx && funcSessionDestroy)
+		{
+			session = funcSessionCreateEx(wadPath, wadFlags);
+			valid = session != NULL;
+		}
+		else if (funcSessionCreate && funcSessionDestroy)
+		{
+			session = funcSessionCreate(wadPath);
+			valid = session != NULL;
+		}
+		else if (funcInitWadEx)
+		{
+			valid = funcInitWadEx(wadPath, wadFlags) >= 0;
+		}
+		else if (funcInitWad)
+		{
+			valid = funcInitWad(wadPath) >= 0;
+		}
+	}
+	~oevSession()
+	{
+		if (session)
+		{
+			funcSessionDestroy(session);
+		}
+		if (library)
+		{
+			FreeLibrary(library);
+		}
+	}
+	oevSession(const oevSession&) = delete;
+	oevSession& operator=(const oevSession&) = delete;
+
+	// false if infogl.dll or the WAD package failed to load
+	bool IsLoaded() const { return library != NULL; }
+	bool IsValid() const { return valid; }
+	HMODULE GetLibrary() const { return library; }
+
+	// Resolve an entry point of infogl.dll, NULL if not exported
+	template <typename T> T GetProc(const char* name) const
+	{
+		return library ? (T)GetProcAddress(library, name) : (T)NULL;
+	}
+
+	// 0 if adapter enumeration is not supported by this infogl.dll
+	int EnumAdapters(struct gvAdapter* adapters, int maxCount) const
+	{
+		for (int i = 0; i < maxCount; i++)
+		{
+			adapters[i].structSize = sizeof(struct gvAdapter);
+		}
+		return funcEnumAdapters ? funcEnumAdapters(adapters, maxCount) : 0;
+	}
+
+	// false if package statistics are not available
+	bool GetWadStats(struct gvWadStats& stats) const
+	{
+		stats.structSize = sizeof(stats);
+		return valid && funcGetWadStats && funcGetWadStats(session, &stats) >= 0;
+	}
+
+	struct gvRenderingTestResult* Run(const char* szXml)
+	{
+		if (!valid)
+		{
+			return NULL;
+		}
+		if (session && funcSessionRun)
+		{
+			return funcSessionRun(session, szXml);
+		}
+		return funcRunRenderingTests ? funcRunRenderingTests(szXml) : NULL;
+	}
+
+	// Release the results of Run(). Older infogl.dll builds own their results, nothing to do
+	void FreeResults(struct gvRenderingTestResult* results) const
+	{
+		if (results && funcFreeRenderingTestResults)
+		{
+			funcFreeRenderingTestResults(results);
+		}
+	}
+
+	// false if this infogl.dll has no trace markers
+	bool EnableTrace(int flags, int capacity = 0) const
+	{
+		if (!funcTraceEnable || !funcTraceGetEvents)
+		{
+			return false;
+		}
+		funcTraceEnable(flags, capacity);
+		return true;
+	}
+
+	// Drain the recorded events of infogl.dll
+	std::vector<struct gvTraceEvent> GetTraceEvents() const
+	{
+		std::vector<struct gvTraceEvent> events;
+		if (!funcTraceGetEvents)
+		{
+			return events;
+		}
+		for (;;)
+		{
+			size_t size = events.size();
+			events.resize(size + 4096);
+			int n = funcTraceGetEvents(&events[size], 4096);
+			events.resize(size + (n > 0 ? n : 0));
+			if (n < 4096)
+			{
+				return events;
+			}
+		}
+	}
+
+	// NULL if asynchronous runs are not supported by this infogl.dll
+	struct gvRenderingJob* RunAsync(const char* szXml, PFNOEVRENDERINGTESTCALLBACK callback, void* userData)
+	{
+		if (!valid || !funcJobWait || !funcJobRelease)
+		{
+			return NULL;
+		}
+		if (session && funcSessionRunAsync)
+		{
+			return funcSessionRunAsync(session, szXml, callback, userData);
+		}
+		return funcRunRenderingTestsAsync ? funcRunRenderingTestsAsync(szXml, callback, userData) : NULL;
+	}
+
+	// Typed configurations, sent as an XML payload to infogl.dll without oevRunRenderingTestsEx
+	struct gvRenderingTestResult* Run(const struct gvRenderingTestConfig* configs, int count)
+	{
+		if (!valid)
+		{
+			return NULL;
+		}
+		if (session && funcSessionRunEx)
+		{
+			return funcSessionRunEx(session, configs, count);
+		}
+		if (!session && funcRunRenderingTestsEx)
+		{
+			return funcRunRenderingTestsEx(configs, count);
+		}
+		return Run(ToXml(configs, count).c_str());
+	}
+
+	struct gvRenderingJob* RunAsync(const struct gvRenderingTestConfig* configs, int count, PFNOEVRENDERINGTESTCALLBACK callback, void* userData)
+	{
+		if (valid && session && funcSessionRunAsyncEx && funcJobWait && funcJobRelease)
+		{
+			return funcSessionRunAsyncEx(session, configs, count, callback, userData);
+		}
+		return RunAsync(ToXml(configs, count).c_str(), callback, userData);
+	}
+
+	// Tests run when gvRenderingTestConfig::tests is NULL, from oevRenderingTests
+	static std::string GetDefaultTests(enum ovRenderer renderer)
+	{
+		std::string tests;
+		for (int i = 0; i < oevRenderingTestCount; i++)
+		{
+			if (oevIsTestSupported(i, renderer))
+			{
+				AppendTest(tests, oevRenderingTests[i].id);
+			}
+		}
+		return tests;
+	}
+
+	// Capability snapshot of a renderer. Loaded from cachePath when the driver did not change and
+	// the snapshot is of the same renderer, else scanned and saved to cachePath. Snapshots do not
+	// record the adapter, use one cachePath per adapter. NULL if not supported, or for another adapter
+	// than the default one with an infogl.dll without oevScanRendererSnapshotEx. Release with funcCapsRelease
+	const struct gvCapabilities* GetCapabilities(enum ovRenderer renderer, const char* cachePath = NULL, int debugMode = 0, int adapter = 0) const
+	{
+		if (!funcCapsRelease || !(funcScanRendererSnapshotEx || (funcScanRendererSnapshot && adapter == 0)))
+		{
+			return NULL;
+		}
+		const struct gvCapabilities* caps = NULL;
+		if (cachePath && funcCapsLoad && funcCapsGetRenderer)
+		{
+			caps = funcCapsLoad(cachePath);
+			if (caps && funcCapsGetRenderer(caps) != renderer)
+			{
+				// Stale or foreign file, overwritten below
+				funcCapsRelease(caps);
+				caps = NULL;
+			}
+		}
+		if (!caps)
+		{
+			caps = funcScanRendererSnapshotEx ? funcScanRendererSnapshotEx(renderer, adapter, debugMode) : funcScanRendererSnapshot(renderer, debugMode);
+			if (caps && cachePath && funcCapsSave)
+			{
+				funcCapsSave(caps, cachePath);
+			}
+		}
+		return caps;
+	}
+
+	// Snapshot of every renderer in one batch, NULL entries are not available.
+	// Scans one renderer at a time with an infogl.dll without oevScanAllRenderers
+	int ScanAllRenderers(const struct gvCapabilities* (&caps)[MAX_RENDERER], int flags = 0) const
+	{
+		int count = 0;
+		for (int i = 0; i < MAX_RENDERER; i++)
+		{
+			caps[i] = NULL;
+		}
+		if (funcScanAllRenderers && funcCapsRelease)
+		{
+			return funcScanAllRenderers(caps, MAX_RENDERER, flags);
+		}
+		for (int i = 0; i < MAX_RENDERER; i++)
+		{
+			caps[i] = GetCapabilities((enum ovRenderer)i, NULL, (flags & OEV_SCAN_DEBUG) ? 1 : 0);
+			count += caps[i] ? 1 : 0;
+		}
+		return count;
+	}
+
+	// Tests of the renderer that the installed driver can run: driver version,
+	// or the extension of the test. Uses a capability snapshot when available.
+	// The default tests when another adapter than the default one cannot be scanned
+	std::string GetRunnableTests(enum ovRenderer renderer, const char* cachePath = NULL, int debugMode = 0, int adapter = 0) const
+	{
+		const char* szVersion = NULL;
+		auto caps = funcCapsGetVersion && funcCapsHasExtension ? GetCapabilities(renderer, cachePath, debugMode, adapter) : NULL;
+		if (caps)
+		{
+			szVersion = funcCapsGetVersion(caps);
+		}
+		else if (adapter == 0 && funcScanRenderer && funcDiagGetVersion && funcScanRenderer(renderer, debugMode) >= 0)
+		{
+			szVersion = funcDiagGetVersion(renderer);
+		}
+		else
+		{
+			return GetDefaultTests(renderer);
+		}
+		// "4.6.0 NVIDIA 512.15", "1.2.170"
+		int version = 0;
+		if (szVersion)
+		{
+			char* end = NULL;
+			auto major = strtol(szVersion, &end, 10);
+			auto minor = end && *end == '.' ? strtol(end + 1, NULL, 10) : 0;
+			version = (int)(major * 10 + (minor < 10 ? minor : 9));
+		}
+		std::string tests;
+		for (int i = 0; i < oevRenderingTestCount; i++)
+		{
+			auto& test = oevRenderingTests[i];
+			if (!oevIsTestSupported(i, renderer))
+			{
+				continue;
+			}
+			auto runnable = version == 0 || version >= test.version;
+			if (!runnable && test.extension)
+			{
+				runnable = caps ? funcCapsHasExtension(caps, test.extension) != 0 :
+					funcDiagHasExtension && funcDiagHasExtension(renderer, "%s", test.extension);
+			}
+			if (runnable)
+			{
+				AppendTest(tests, test.id);
+			}
+		}
+		if (caps)
+		{
+			funcCapsRelease(caps);
+		}
+		return tests;
+	}
+
+	// XML payload of typed configurations
+	static std::string ToXml(const struct gvRenderingTestConfig* configs, int count)
+	{
+		static const char* const fbformats[] = { "Linear", "sRGB", "HDR" };
+		std::string xml;
+		xml.reserve(16 + 384 * (size_t)count);
+		xml += "<root>";
+		for (int i = 0; i < count; i++)
+		{
+			const struct gvRenderingTestConfig& config = configs[i];
+			if (count > 1)
+			{
+				xml += "<config>";
+			}
+			AppendElement(xml, "option", std::to_string(config.option).c_str());
+			AppendElement(xml, "fbformat", config.fbformat >= WGLDIAG_FB_LINEAR && config.fbformat <= WGLDIAG_FB_HDR ? fbformats[config.fbformat] : fbformats[0]);
+			AppendElement(xml, "duration", std::to_string(config.duration).c_str());
+			AppendElement(xml, "multisample", std::to_string(config.multisample).c_str());
+			AppendElement(xml, "anisotropy", std::to_string(config.anisotropy).c_str());
+			AppendElement(xml, "texturelod", std::to_string(config.textureLod).c_str());
+			AppendElement(xml, "displaymode", std::to_string(config.displayMode).c_str());
+			AppendElement(xml, "renderer", std::to_string(config.renderer).c_str());
+			AppendElement(xml, "pixelformat", std::to_string(config.pixelFormat).c_str());
+			AppendElement(xml, "test", config.tests ? config.tests : GetDefaultTests(config.renderer).c_str());
+			AppendElement(xml, "fbenable", config.fbenable ? config.fbenable : "Default");
+			AppendElement(xml, "scene", std::to_string(config.scene).c_str());
+			AppendElement(xml, "width", std::to_string(config.width).c_str());
+			AppendElement(xml, "height", std::to_string(config.height).c_str());
+			if (config.adapter)
+			{
+				AppendElement(xml, "adapter", std::to_string(config.adapter).c_str());
+			}
+			if (config.pipelineCache)
+			{
+				AppendElement(xml, "pipelinecache", config.pipelineCache);
+			}
+			if (config.targetRse > 0)
+			{
+				AppendElement(xml, "targetrse", std::to_string(config.targetRse).c_str());
+				AppendElement(xml, "minduration", std::to_string(config.minDuration).c_str());
+			}
+			if (config.telemetryInterval)
+			{
+				AppendElement(xml, "telemetry", std::to_string(config.telemetryInterval).c_str());
+			}
+			if (config.scene == OEV_SCENE_DRAWCALLS)
+			{
+				AppendElement(xml, "objects", std::to_string(config.objectCount).c_str());
+				AppendElement(xml, "drawmodes", std::to_string(config.drawModes).c_str());
+			}
+			if (config.scene == OEV_SCENE_STREAMING)
+			{
+				AppendElement(xml, "streambudget", std::to_string(config.streamBudget).c_str());
+				AppendElement(xml, "streamdepth", std::to_string(config.streamQueueDepth).c_str());
+			}
+			if (config.fbformatMask)
+			{
+				AppendElement(xml, "fbformatmask", std::to_string(config.fbformatMask).c_str());
+			}
+			if (config.multisampleMask)
+			{
+				AppendElement(xml, "multisamplemask", std::to_string(config.multisampleMask).c_str());
+			}
+			if (config.workerThreads)
+			{
+				AppendElement(xml, "threads", std::to_string(config.workerThreads).c_str());
+			}
+			if (config.warmup)
+			{
+				AppendElement(xml, "warmup", std::to_string(config.warmup).c_str());
+				AppendElement(xml, "warmuptolerance", std::to_string(config.warmupTolerance).c_str());
+				AppendElement(xml, "warmupwindow", std::to_string(config.warmupWindow).c_str());
+			}
+			if (count > 1)
+			{
+				xml += "</config>";
+			}
+		}
+		xml += "</root>";
+		return xml;
+	}
+
+	PFNOEVREADCPUID funcReadCpuid = NULL;
+	PFNOEVINITWAD funcInitWad = NULL;
+	PNFNOEVRUNRENDERINGTESTS funcRunRenderingTests = NULL;
+	PFNOEVRUNRENDERINGTESTSASYNC funcRunRenderingTestsAsync = NULL;
+	PFNOEVJOBPOLL funcJobPoll = NULL;
+	PFNOEVJOBWAIT funcJobWait = NULL;
+	PFNOEVJOBCANCEL funcJobCancel = NULL;
+	PFNOEVJOBGETRESULTS funcJobGetResults = NULL;
+	PFNOEVJOBRELEASE funcJobRelease = NULL;
+	PFNOEVSESSIONCREATE funcSessionCreate = NULL;
+	PFNOEVSESSIONRUN funcSessionRun = NULL;
+	PFNOEVSESSIONRUNASYNC funcSessionRunAsync = NULL;
+	PFNOEVSESSIONDESTROY funcSessionDestroy = NULL;
+	PFNOEVINITWADEX funcInitWadEx = NULL;
+	PFNOEVSESSIONCREATEEX funcSessionCreateEx = NULL;
+	PFNOEVGETWADSTATS funcGetWadStats = NULL;
+	PFNOEVRUNRENDERINGTESTSEX funcRunRenderingTestsEx = NULL;
+	PFNOEVSESSIONRUNEX funcSessionRunEx = NULL;
+	PFNOEVSESSIONRUNASYNCEX funcSessionRunAsyncEx = NULL;
+	PFNOEVENUMADAPTERS funcEnumAdapters = NULL;
+	PFNOEVSCANRENDERER funcScanRenderer = NULL;
+	PFNOEVDIAGGETVERSION funcDiagGetVersion = NULL;
+	PFNOEVDIAGGETRENDERERNAME funcDiagGetRendererName = NULL;
+	PFNOEVDIAGGETVENDORNAME funcDiagGetVendorName = NULL;
+	PFNOEVDIAGHASEXTENSION funcDiagHasExtension = NULL;
+	PFNOEVSCANRENDERERSNAPSHOT funcScanRendererSnapshot = NULL;
+	PFNOEVSCANRENDERERSNAPSHOTEX funcScanRendererSnapshotEx = NULL;
+	PFNOEVCAPSLOAD funcCapsLoad = NULL;
+	PFNOEVCAPSSAVE funcCapsSave = NULL;
+	PFNOEVCAPSRELEASE funcCapsRelease = NULL;
+	PFNOEVCAPSGETRENDERER funcCapsGetRenderer = NULL;
+	PFNOEVCAPSGETVERSION funcCapsGetVersion = NULL;
+	PFNOEVCAPSHASEXTENSION funcCapsHasExtension = NULL;
+	PFNOEVCAPSGETLIMIT funcCapsGetLimit = NULL;
+	PFNOEVCAPSGETRENDERERNAME funcCapsGetRendererName = NULL;
+	PFNOEVCAPSGETVENDORNAME funcCapsGetVendorName = NULL;
+	PFNOEVSCANALLRENDERERS funcScanAllRenderers = NULL;
+	PFNOEVFREERENDERINGTESTRESULTS funcFreeRenderingTestResults = NULL;
+	PFNOEVTRACEENABLE funcTraceEnable = NULL;
+	PFNOEVTRACEGETEVENTS funcTraceGetEvents = NULL;
+
+private:
+	static void AppendTest(std::string& tests, const char* id)
+	{
+		if (!tests.empty())
+		{
+			tests += ';';
+		}
+		tests += id;
+	}
+
+	static void AppendElement(std::string& xml, const char* name, const char* value)
+	{
+		xml += '<';
+		xml += name;
+		xml += '>';
+		xml += value;
+		xml += "</";
+		xml += name;
+		xml += '>';
+	}
+
+	HMODULE library = NULL;
+	struct gvSession* session = NULL;
+	bool valid = false;
+};
+
+#define OEV_DISPLAYMODE_NOT_FOUND (-1)
+
+// Display modes of a monitor, enumerated once.
+// Indices are the EnumDisplaySettings mode numbers expected by gvRenderingTestConfig::displayMode.
+class oevDisplayModes
+{
+public:
+	// deviceName is a name from GetMonitors(), NULL for the primary monitor
+	explicit oevDisplayModes(const char* deviceName = NULL)
+	{
+		DEVMODEA devmode = {};
+		devmode.dmSize = sizeof(devmode);
+		for (DWORD n = 0; EnumDisplaySettingsA(deviceName, n, &devmode); n++)
+		{
+			int width = (int)devmode.dmPelsWidth;
+			int height = (int)devmode.dmPelsHeight;
+			int refreshRate = (int)devmode.dmDisplayFrequency;
+			int bitsPerPixel = (int)devmode.dmBitsPerPel;
+			// Wildcard entries keep the first matching mode
+			modes.emplace(Key(width, height, refreshRate, bitsPerPixel), (int)n);
+			modes.emplace(Key(width, height, refreshRate, 0), (int)n);
+			modes.emplace(Key(width, height, 0, bitsPerPixel), (int)n);
+			modes.emplace(Key(width, height, 0, 0), (int)n);
+			count++;
+		}
+	}
+
+	// Mode index or OEV_DISPLAYMODE_NOT_FOUND. refreshRate and bitsPerPixel 0 match any
+	int Find(int width, int height, int refreshRate = 0, int bitsPerPixel = 0) const
+	{
+		auto it = modes.find(Key(width, height, refreshRate, bitsPerPixel));
+		return it != modes.end() ? it->second : OEV_DISPLAYMODE_NOT_FOUND;
+	}
+
+	int GetCount() const { return count; }
+
+	// Device names of the monitors attached to the desktop, primary first
+	static std::vector<std::string> GetMonitors()
+	{
+		std::vector<std::string> monitors;
+		DISPLAY_DEVICEA device = {};
+		device.cb = sizeof(device);
+		for (DWORD n = 0; EnumDisplayDevicesA(NULL, n, &device, 0); n++)
+		{
+			if (device.StateFlags & DISPLAY_DEVICE_ATTACHED_TO_DESKTOP)
+			{
+				if (device.StateFlags & DISPLAY_DEVICE_PRIMARY_DEVICE)
+				{
+					monitors.insert(monitors.begin(), device.DeviceName);
+				}
+				else
+				{
+					monitors.push_back(device.DeviceName);
+				}
+			}
+		}
+		return monitors;
+	}
+
+private:
+	static unsigned long long Key(int width, int height, int refreshRate, int bitsPerPixel)
+	{
+		return ((unsigned long long)(width & 0xffff) << 48) | ((unsigned long long)(height & 0xffff) << 32) |
+			((unsigned long long)(refreshRate & 0xffff) << 16) | (unsigned long long)(bitsPerPixel & 0xffff);
+	}
+	std::unordered_map<unsigned long long, int> modes;
+	int count = 0;
+};
 #endif
@@ -0,0 +1,335 @@
+/****************************************************************************
+; *
+; * 	File		:	oevAgent.cpp
+; *
+; * 	Description :	Remote benchmark worker
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <atomic>
+#include "oevAgent.h"
+#include "oevLog.h"
+#pragma comment(lib, "Ws2_32.lib")
+
+static DebugLog Log;
+
+// Milliseconds a send may block, a client that stops reading is dropped instead of stalling the batches
+static const DWORD kSendTimeout = 10000;
+
+struct AgentConnection
+{
+	AgentConnection(SOCKET socket, const char* host, bool local) : socket(socket), host(host), local(local) {}
+	~AgentConnection()
+	{
+		// Sends what is still buffered before the socket goes away
+		writer.reset();
+		closesocket(socket);
+	}
+	bool Send(const char* data, size_t size)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (size > 0 && open.load())
+		{
+			auto n = send(socket, data, (int)(size < 0x10000 ? size : 0x10000), 0);
+			if (n <= 0)
+			{
+				if (WSAGetLastError() == WSAETIMEDOUT)
+				{
+					Log.e("Agent: client not reading for %d ms, dropped", (int)kSendTimeout);
+				}
+				// The socket is unusable after a timeout, also unblocks the reader thread
+				open.store(false);
+				shutdown(socket, SD_BOTH);
+				return false;
+			}
+			data += n;
+			size -= n;
+		}
+		return size == 0;
+	}
+	SOCKET socket;
+	std::string host;
+	bool local; // Loopback peer
+	std::mutex mutex;
+	std::atomic<bool> open{ true };
+	std::atomic<bool> finished{ false }; // Reader thread done
+	int queued = 0; // Batches not run yet, guarded by the agent mutex
+	std::unique_ptr<ResultWriter> writer;
+	std::thread thread;
+};
+
+// Without the spaces and tabs around
+static std::string trim(const std::string& line)
+{
+	auto first = line.find_first_not_of(" \t\r");
+	return first == std::string::npos ? std::string() : line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+}
+
+Agent::Agent(const TestOptions& defaults, ResultFormat format, const std::string& identity, const std::string& token) :
+	defaults(defaults),
+	format(format),
+	identity(identity),
+	token(token),
+	listener((uintptr_t)INVALID_SOCKET)
+{
+}
+Agent::~Agent()
+{
+	Stop();
+}
+bool Agent::Start(int port, const char* address)
+{
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+	{
+		return false;
+	}
+	started = true;
+	auto s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s == INVALID_SOCKET)
+	{
+		return false;
+	}
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_port = htons((u_short)port);
+	if (inet_pton(AF_INET, address, &local.sin_addr) != 1)
+	{
+		Log.e("Agent: bad address %s", address);
+		closesocket(s);
+		return false;
+	}
+	if (bind(s, (const sockaddr*)&local, sizeof(local)) == SOCKET_ERROR || listen(s, SOMAXCONN) == SOCKET_ERROR)
+	{
+		Log.e("Agent: cannot listen on %s:%d (%d)", address, port, WSAGetLastError());
+		closesocket(s);
+		return false;
+	}
+	listener = (uintptr_t)s;
+	acceptThread = std::thread(&Agent::Accept, this);
+	Log.v("Agent: listening on %s:%d%s", address, port, token.empty() ? ", no token" : "");
+	return true;
+}
+void Agent::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		queue.clear();
+	}
+	wake.notify_all();
+	if ((SOCKET)listener != INVALID_SOCKET)
+	{
+		// Unblocks accept()
+		closesocket((SOCKET)listener);
+		listener = (uintptr_t)INVALID_SOCKET;
+	}
+	if (acceptThread.joinable())
+	{
+		acceptThread.join();
+	}
+	for (auto& connection : connections)
+	{
+		// Unblocks recv()
+		shutdown(connection->socket, SD_BOTH);
+		if (connection->thread.joinable())
+		{
+			connection->thread.join();
+		}
+	}
+	connections.clear();
+	if (started)
+	{
+		WSACleanup();
+		started = false;
+	}
+}
+void Agent::Accept()
+{
+	for (;;)
+	{
+		sockaddr_in address = {};
+		int length = sizeof(address);
+		auto s = accept((SOCKET)listener, (sockaddr*)&address, &length);
+		if (s == INVALID_SOCKET)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (stopping)
+			{
+				break;
+			}
+			continue;
+		}
+		char host[INET_ADDRSTRLEN] = "?";
+		inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host));
+		Log.v("Agent: client %s connected", host);
+		setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&kSendTimeout, sizeof(kSendTimeout));
+		auto connection = std::make_shared<AgentConnection>(s, host, (ntohl(address.sin_addr.s_addr) >> 24) == 127);
+		auto raw = connection.get();
+		connection->writer = ResultWriter::Open([raw](const char* data, size_t size) { return raw->Send(data, size); }, format, false);
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping)
+		{
+			break;
+		}
+		// Forget the clients that went away
+		for (auto it = connections.begin(); it != connections.end();)
+		{
+			if ((*it)->finished.load())
+			{
+				(*it)->thread.join();
+				it = connections.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		connection->thread = std::thread(&Agent::Read, this, connection);
+		connections.push_back(connection);
+	}
+}
+void Agent::Read(std::shared_ptr<AgentConnection> connection)
+{
+	auto s = connection->socket;
+	LineReader reader([s](char* buffer, int size) { return recv(s, buffer, size, 0); });
+	std::vector<TestOptions> pending;
+	std::string line;
+	auto eof = false;
+	if (!token.empty() && !(reader.ReadLine(line) && trim(line) == "token " + token))
+	{
+		Log.e("Agent: client %s rejected, bad token", connection->host.c_str());
+		connection->writer->WriteEvent("unauthorized", 0, -10);
+		eof = true;
+	}
+	else
+	{
+		// Identity first, whatever the result format
+		auto hello = identity + "\n";
+		connection->Send(hello.data(), hello.size());
+	}
+	while (connection->open.load() && !eof)
+	{
+		eof = !reader.ReadLine(line);
+		auto comment = line.find('#');
+		if (eof || comment != std::string::npos)
+		{
+			line.resize(eof ? 0 : comment);
+		}
+		auto command = trim(line);
+		if (command == "shutdown" && !connection->local && token.empty())
+		{
+			Log.e("Agent: shutdown refused from %s, no token", connection->host.c_str());
+			connection->writer->WriteEvent("invalid", 0, -10);
+			continue;
+		}
+		if (command == "shutdown")
+		{
+			Log.v("Agent: shutdown requested");
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			break;
+		}
+		auto quit = command == "quit";
+		if (command.empty() || command == "run" || quit || eof)
+		{
+			// A client can also half-close its side after the last batch and wait for the results
+			if (!pending.empty())
+			{
+				int id;
+				int position;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					id = nextBatch++;
+					position = (int)queue.size();
+					queue.push_back({ connection, std::move(pending), id });
+					connection->queued++;
+				}
+				pending.clear();
+				wake.notify_all();
+				// Number of batches ahead of this one
+				connection->writer->WriteEvent("queued", id, position);
+			}
+			if (quit)
+			{
+				break;
+			}
+			continue;
+		}
+		auto options = defaults;
+		std::string error;
+		auto ok = ParseTestOptions(command.c_str(), options, error);
+		if (ok && !connection->local && options.cache != defaults.cache)
+		{
+			// Paths of the agent machine stay under the control of its operator
+			error = "cache= from " + connection->host;
+			ok = false;
+		}
+		if (ok)
+		{
+			pending.push_back(options);
+		}
+		else
+		{
+			Log.e("Agent: %s", error.c_str());
+			connection->writer->WriteEvent("invalid", 0, -8);
+		}
+	}
+	connection->writer->Flush();
+	std::lock_guard<std::mutex> lock(mutex);
+	connection->finished.store(true);
+	if (connection->queued == 0)
+	{
+		// Client sees the end of the stream, otherwise after its last batch
+		shutdown(s, SD_SEND);
+	}
+}
+int Agent::Run(const BatchHandler& handler)
+{
+	for (;;)
+	{
+		Batch batch;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || !queue.empty(); });
+			if (stopping)
+			{
+				break;
+			}
+			batch = std::move(queue.front());
+			queue.pop_front();
+		}
+		auto& connection = batch.connection;
+		if (connection->open.load())
+		{
+			auto writer = connection->writer.get();
+			auto status = handler(batch.list, writer);
+			writer->WriteEvent("batch", batch.id, status);
+			writer->Flush();
+		}
+		else
+		{
+			Log.v("Agent: batch %d skipped, client disconnected", batch.id);
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--connection->queued == 0 && connection->finished.load())
+		{
+			shutdown(connection->socket, SD_SEND);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,87 @@
+/****************************************************************************
+; *
+; * 	File		:	oevAgent.h
+; *
+; * 	Description :	Remote benchmark worker
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <stdint.h>
+#include "oevConfig.h"
+#include "oevResultWriter.h"
+
+struct AgentConnection;
+
+/// <summary>
+/// TCP listener accepting batches of configurations from a scheduler.
+/// The protocol is the one of --serve: one configuration per line, an empty line or "run"
+/// queues the batch, "quit" or closing the sending side ends the submissions and "shutdown"
+/// stops the agent. The connection is closed after the last batch of the client.
+/// The agent sends its identity line first, then the results of each test as soon as it
+/// finishes, a "queued" event when a batch is accepted and a "batch" event when it is done.
+/// Batches of all the connections run one at a time, in order, on a single warm session.
+/// A client that does not read its results for 10 s is disconnected.
+/// The agent listens on the loopback interface unless another address is given. With a token,
+/// clients must send "token <secret>" as their first line, before anything is sent to them.
+/// Clients from other hosts cannot set cache=, a path of the agent machine, and can only send
+/// "shutdown" when a token is required.
+/// </summary>
+class Agent
+{
+public:
+	// Runs a batch on the session, returns the status reported in the "batch" event
+	typedef std::function<int(const std::vector<TestOptions>& batch, ResultWriter* writer)> BatchHandler;
+
+	Agent(const TestOptions& defaults, ResultFormat format, const std::string& identity, const std::string& token = std::string());
+	~Agent();
+	Agent(const Agent&) = delete;
+	Agent& operator=(const Agent&) = delete;
+
+	// Listen on address, an IPv4 address, 0.0.0.0 for every interface
+	bool Start(int port, const char* address = "127.0.0.1");
+	// Run the queued batches on the calling thread until a client sends "shutdown"
+	int Run(const BatchHandler& handler);
+
+private:
+	struct Batch
+	{
+		std::shared_ptr<AgentConnection> connection;
+		std::vector<TestOptions> list;
+		int id;
+	};
+	void Accept();
+	void Read(std::shared_ptr<AgentConnection> connection);
+	void Stop();
+
+	TestOptions defaults;
+	ResultFormat format;
+	std::string identity; // JSON object, first line sent to every client
+	std::string token; // Empty: no authentication
+	uintptr_t listener; // SOCKET, winsock stays out of this header
+	bool started = false;
+	std::thread acceptThread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Batch> queue;
+	std::vector<std::shared_ptr<AgentConnection>> connections;
+	int nextBatch = 1;
+	bool stopping = false;
+};
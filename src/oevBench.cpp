@@ -0,0 +1,753 @@
+/****************************************************************************
+; *
+; * 	File		:	oevBench.cpp
+; *
+; * 	Description :	Benchmark harness, baselines and regression checks
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+// Usage: GLViewBench [suite] [--runs N] [--baseline dir] [--update] [--reference driver] [--alpha p] [--threshold r] [--results path]
+//
+// Runs a suite N times on one session. With --update the samples are stored as the baseline,
+// otherwise they are compared with it. Baselines are keyed by CPU signature, renderer name
+// and driver version. Without a baseline of the installed driver, the newest baseline of the
+// same CPU and renderer is the reference, so a driver update is compared with the previous
+// driver. --reference picks the driver version to compare with.
+//
+// Exit codes
+#define BENCH_EXIT_PASS 0
+#define BENCH_EXIT_REGRESSION 1 // Significant fps or frame time regression
+#define BENCH_EXIT_NO_BASELINE 2 // First run for this CPU and renderer, or no baseline of --reference
+#define BENCH_EXIT_ERROR 3 // Bad arguments, infogl.dll missing or tests failed
+
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <Windows.h>
+#include "include/oevSDK.h"
+#include "oevResultWriter.h"
+#include "oevLog.h"
+static DebugLog Log;
+
+struct BenchSuite
+{
+	const char* name;
+	ovRenderer renderer;
+	int multisample[4]; // One configuration per level, -1 terminated
+	int width;
+	int height;
+	int duration;
+	int option; // WGLDIAG_OPTION_*
+	int scene;
+	int objectCount; // OEV_SCENE_DRAWCALLS
+	int drawModes;
+	int streamBudget; // OEV_SCENE_STREAMING
+	int streamQueueDepth;
+	int fbformatMask; // Format cycle, one series per combination
+	int multisampleMask;
+};
+
+// Offscreen by default, no compositor or window placement noise
+#define BENCH_HEADLESS WGLDIAG_OPTION_HEADLESS
+// Presentation latency needs a real swapchain on the primary monitor
+#define BENCH_PRESENT (WGLDIAG_OPTION_FS | WGLDIAG_OPTIONS_FS_EX | WGLDIAG_OPTION_VSYNC | WGLDIAG_OPTION_LATENCY)
+
+static const BenchSuite kSuites[] =
+{
+	{ "quick", RENDERER_GL4_6, { 0, -1 }, 1280, 720, 10, BENCH_HEADLESS },
+	{ "msaa", RENDERER_GL4_6, { 0, 4, 8, -1 }, 1920, 1080, 20, BENCH_HEADLESS },
+	{ "vulkan", RENDERER_VK1_2, { 0, 4, -1 }, 1920, 1080, 20, BENCH_HEADLESS },
+	{ "legacy", RENDERER_GL2_0, { 0, -1 }, 1280, 720, 10, BENCH_HEADLESS },
+	{ "gdi", RENDERER_GDI, { 0, -1 }, 640, 480, 10, BENCH_HEADLESS },
+	{ "latency", RENDERER_VK1_2, { 0, -1 }, 1920, 1080, 20, BENCH_PRESENT },
+	{ "latency-gl", RENDERER_GL4_6, { 0, -1 }, 1920, 1080, 20, BENCH_PRESENT },
+	{ "drawcalls", RENDERER_GL4_6, { 0, -1 }, 1280, 720, 20, BENCH_HEADLESS, OEV_SCENE_DRAWCALLS, 20000, OEV_DRAW_ALL },
+	{ "drawcalls-vk", RENDERER_VK1_2, { 0, -1 }, 1280, 720, 20, BENCH_HEADLESS, OEV_SCENE_DRAWCALLS, 20000, OEV_DRAW_ALL },
+	{ "streaming", RENDERER_GL4_6, { 0, -1 }, 1920, 1080, 20, BENCH_HEADLESS, OEV_SCENE_STREAMING, 0, 0, 256, 4 },
+	{ "streaming-vk", RENDERER_VK1_2, { 0, -1 }, 1920, 1080, 20, BENCH_HEADLESS, OEV_SCENE_STREAMING, 0, 0, 256, 4 },
+	{ "formats", RENDERER_GL4_6, { 0, -1 }, 1920, 1080, 10, BENCH_HEADLESS, 0, 0, 0, 0, 0, OEV_FBFORMAT_ALL, 1 | 4 | 8 },
+	{ "formats-vk", RENDERER_VK1_2, { 0, -1 }, 1920, 1080, 10, BENCH_HEADLESS, 0, 0, 0, 0, 0, OEV_FBFORMAT_ALL, 1 | 4 | 8 },
+};
+
+struct BenchOptions
+{
+	const BenchSuite* suite = &kSuites[0];
+	int runs = 5;
+	std::string baselineDir = "baselines";
+	const char* resultsPath = nullptr;
+	bool update = false;
+	std::string reference; // --reference driver, baseline of another driver version
+	double alpha = 0.05; // Two-sided significance level
+	double threshold = 0.03; // Relative median change below which differences are ignored
+};
+
+// Samples of one test and one metric, one per run
+struct BenchSeries
+{
+	bool higherIsBetter;
+	std::vector<double> values;
+};
+
+// "<metric> <config>:<test>[/<draw mode>]" -> samples
+typedef std::map<std::string, BenchSeries> BenchSamples;
+
+struct BenchIdentity
+{
+	std::string signature;
+	std::string renderer;
+	std::string driver;
+};
+
+static bool parse_options(int argc, char** argv, BenchOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		auto hasValue = i + 1 < argc;
+		if (arg == "--runs" && hasValue)
+		{
+			options.runs = atoi(argv[++i]);
+		}
+		else if (arg == "--baseline" && hasValue)
+		{
+			options.baselineDir = argv[++i];
+		}
+		else if (arg == "--alpha" && hasValue)
+		{
+			options.alpha = atof(argv[++i]);
+		}
+		else if (arg == "--threshold" && hasValue)
+		{
+			options.threshold = atof(argv[++i]);
+		}
+		else if (arg == "--results" && hasValue)
+		{
+			options.resultsPath = argv[++i];
+		}
+		else if (arg == "--reference" && hasValue)
+		{
+			options.reference = argv[++i];
+		}
+		else if (arg == "--update")
+		{
+			options.update = true;
+		}
+		else if (arg[0] != '-')
+		{
+			options.suite = nullptr;
+			for (auto& suite : kSuites)
+			{
+				if (arg == suite.name)
+				{
+					options.suite = &suite;
+				}
+			}
+			if (!options.suite)
+			{
+				fprintf(stderr, "Unknown suite %s\n", arg.c_str());
+				return false;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", arg.c_str());
+			return false;
+		}
+	}
+	// The exact Mann-Whitney test cannot reach p < 0.05 with less than 4 runs per side
+	if (options.runs < 4 || options.alpha <= 0 || options.alpha >= 1 || options.threshold < 0)
+	{
+		fprintf(stderr, "Usage: GLViewBench [suite] [--runs N (>= 4)] [--baseline dir] [--update] [--reference driver] [--alpha p] [--threshold r] [--results path]\n");
+		return false;
+	}
+	return true;
+}
+
+// Keep file name characters only
+static std::string sanitize(const char* text)
+{
+	std::string out;
+	for (auto p = text; p && *p; p++)
+	{
+		auto c = *p;
+		out += (isalnum((unsigned char)c) || c == '.' || c == '-') ? c : '_';
+	}
+	return out.empty() ? "unknown" : out;
+}
+
+static BenchIdentity get_identity(const oevSession& session, ovRenderer renderer)
+{
+	BenchIdentity identity;
+	char signature[16] = "0";
+	if (session.funcReadCpuid)
+	{
+		struct gvCpuid processorInfo = {};
+		if (session.funcReadCpuid(&processorInfo) >= 0)
+		{
+			snprintf(signature, sizeof(signature), "%08X", (unsigned)processorInfo.Signature);
+		}
+	}
+	identity.signature = signature;
+	// Rescan, the baseline must follow the driver actually installed
+	auto caps = session.GetCapabilities(renderer);
+	if (caps)
+	{
+		identity.renderer = sanitize(session.funcCapsGetRendererName ? session.funcCapsGetRendererName(caps) : nullptr);
+		identity.driver = sanitize(session.funcCapsGetVersion ? session.funcCapsGetVersion(caps) : nullptr);
+		session.funcCapsRelease(caps);
+	}
+	else
+	{
+		auto scanned = session.funcScanRenderer && session.funcScanRenderer(renderer, 0) >= 0;
+		identity.renderer = sanitize(scanned && session.funcDiagGetRendererName ? session.funcDiagGetRendererName(renderer) : nullptr);
+		identity.driver = sanitize(scanned && session.funcDiagGetVersion ? session.funcDiagGetVersion(renderer) : nullptr);
+	}
+	return identity;
+}
+
+static std::string get_baseline_path(const BenchOptions& options, const BenchIdentity& identity)
+{
+	return options.baselineDir + "\\" + options.suite->name + "_" + identity.signature + "_" + identity.renderer + "_" + identity.driver + ".txt";
+}
+
+/// <summary>
+/// Run the suite once and append one sample per test to each series
+/// </summary>
+/// <returns>Number of failed tests, -1 if nothing ran</returns>
+static int run_suite(oevSession& session, const std::vector<gvRenderingTestConfig>& configs, BenchSamples& samples, ResultWriter* writer)
+{
+	auto lpResults = session.Run(configs.data(), (int)configs.size());
+	if (!lpResults)
+	{
+		return -1;
+	}
+	auto failed = 0;
+	for (auto lpResult = lpResults; lpResult; lpResult = lpResult->next)
+	{
+		if (writer)
+		{
+			writer->Write(lpResult);
+		}
+		auto configIndex = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, configIndex) ? lpResult->configIndex : 0;
+		auto cycle = configIndex < (int)configs.size() && (configs[configIndex].fbformatMask || configs[configIndex].multisampleMask);
+		if (cycle && OEV_HAS_FIELD(lpResult, gvRenderingTestResult, status) && lpResult->status == TESTSTATUS_UNSUPPORTED)
+		{
+			// HDR without an HDR capable display, sample counts above the device limit
+			continue;
+		}
+		if (!oevIsTestPassed(lpResult))
+		{
+			Log.e("Test %d failed: %s", lpResult->index, lpResult->result ? lpResult->result : "");
+			failed++;
+			continue;
+		}
+		auto key = std::to_string(configIndex) + ":" + std::to_string(lpResult->index);
+		if (cycle && OEV_HAS_FIELD(lpResult, gvRenderingTestResult, multisample))
+		{
+			key += "@" + std::to_string(lpResult->fbformat) + "x" + std::to_string(lpResult->multisample);
+		}
+		auto& fps = samples["fps " + key];
+		fps.higherIsBetter = true;
+		fps.values.push_back(lpResult->fps);
+		auto timings = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, frameTimings) ? lpResult->frameTimings : nullptr;
+		if (timings && timings->frameCount)
+		{
+			auto& p99 = samples["p99 " + key];
+			p99.higherIsBetter = false;
+			p99.values.push_back(timings->p99);
+		}
+		auto drawModes = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, drawModes) ? lpResult->drawModes : nullptr;
+		for (int i = 0; drawModes && i < lpResult->drawModeCount; i++)
+		{
+			if (drawModes[i].mode == 0)
+			{
+				continue;
+			}
+			auto modeKey = key + "/" + std::to_string(drawModes[i].mode);
+			auto& dps = samples["dps " + modeKey];
+			dps.higherIsBetter = true;
+			dps.values.push_back(drawModes[i].drawsPerSecond);
+			auto& cpu = samples["cpu " + modeKey];
+			cpu.higherIsBetter = false;
+			cpu.values.push_back(drawModes[i].cpuTime);
+		}
+		auto streaming = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, streaming) ? lpResult->streaming : nullptr;
+		if (streaming)
+		{
+			auto& gbps = samples["gbps " + key];
+			gbps.higherIsBetter = true;
+			gbps.values.push_back(streaming->throughput);
+			auto& upload99 = samples["up99 " + key];
+			upload99.higherIsBetter = false;
+			upload99.values.push_back(streaming->latencyP99);
+		}
+		auto latency = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, latency) ? lpResult->latency : nullptr;
+		if (latency && latency->source != LATENCY_NONE && latency->presentCount)
+		{
+			auto& lat99 = samples["lat99 " + key];
+			lat99.higherIsBetter = false;
+			lat99.values.push_back(latency->p99);
+		}
+	}
+	session.FreeResults(lpResults);
+	return failed;
+}
+
+static bool save_baseline(const char* path, const BenchIdentity& identity, const BenchSamples& samples)
+{
+	std::string text = "signature " + identity.signature + "\nrenderer " + identity.renderer + "\ndriver " + identity.driver + "\n";
+	for (auto& series : samples)
+	{
+		text += series.first;
+		text += series.second.higherIsBetter ? " +" : " -";
+		for (auto value : series.second.values)
+		{
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), " %.9g", value);
+			text += buffer;
+		}
+		text += '\n';
+	}
+	auto handle = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	DWORD n = 0;
+	auto ok = WriteFile(handle, text.data(), (DWORD)text.size(), &n, nullptr) && n == text.size();
+	CloseHandle(handle);
+	return ok != FALSE;
+}
+
+static bool load_baseline(const char* path, BenchSamples& samples, BenchIdentity* identity = nullptr)
+{
+	auto handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	std::string text(GetFileSize(handle, nullptr), '\0');
+	DWORD n = 0;
+	auto ok = ReadFile(handle, &text[0], (DWORD)text.size(), &n, nullptr) && n == text.size();
+	CloseHandle(handle);
+	if (!ok)
+	{
+		return false;
+	}
+	// <metric> <key> <+|-> <values...>, identity lines have no sign and are skipped
+	size_t start = 0;
+	while (start < text.size())
+	{
+		auto end = text.find('\n', start);
+		if (end == std::string::npos)
+		{
+			end = text.size();
+		}
+		auto line = text.substr(start, end - start);
+		start = end + 1;
+		auto metricEnd = line.find(' ');
+		if (identity && metricEnd != std::string::npos)
+		{
+			auto name = line.substr(0, metricEnd);
+			auto value = line.substr(metricEnd + 1);
+			if (name == "signature")
+			{
+				identity->signature = value;
+			}
+			else if (name == "renderer")
+			{
+				identity->renderer = value;
+			}
+			else if (name == "driver")
+			{
+				identity->driver = value;
+			}
+		}
+		auto keyEnd = metricEnd == std::string::npos ? metricEnd : line.find(' ', metricEnd + 1);
+		if (keyEnd == std::string::npos || keyEnd + 1 >= line.size() || (line[keyEnd + 1] != '+' && line[keyEnd + 1] != '-'))
+		{
+			continue;
+		}
+		auto& series = samples[line.substr(0, keyEnd)];
+		series.higherIsBetter = line[keyEnd + 1] == '+';
+		auto p = line.c_str() + keyEnd + 2;
+		for (;;)
+		{
+			char* next = nullptr;
+			auto value = strtod(p, &next);
+			if (next == p)
+			{
+				break;
+			}
+			series.values.push_back(value);
+			p = next;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Baseline to compare with: the one of --reference, else the one of the installed driver,
+/// else the newest one of the same CPU signature and renderer
+/// </summary>
+/// <param name="path">Set to the baseline file, or to the one that was expected</param>
+/// <param name="reference">Identity stored in the baseline</param>
+/// <returns>false if there is none</returns>
+static bool find_baseline(const BenchOptions& options, const BenchIdentity& identity, std::string& path, BenchSamples& samples, BenchIdentity& reference)
+{
+	auto wanted = identity;
+	if (!options.reference.empty())
+	{
+		wanted.driver = sanitize(options.reference.c_str());
+	}
+	path = get_baseline_path(options, wanted);
+	if (load_baseline(path.c_str(), samples, &reference))
+	{
+		return true;
+	}
+	if (!options.reference.empty())
+	{
+		return false;
+	}
+	WIN32_FIND_DATAA data;
+	auto pattern = options.baselineDir + "\\" + options.suite->name + "_" + identity.signature + "_" + identity.renderer + "_*.txt";
+	auto find = FindFirstFileA(pattern.c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	auto found = false;
+	FILETIME newest = {};
+	do
+	{
+		// The pattern also matches renderer names extending this one, the identity lines tell them apart
+		auto candidate = options.baselineDir + "\\" + data.cFileName;
+		BenchSamples candidateSamples;
+		BenchIdentity candidateIdentity;
+		if ((!found || CompareFileTime(&data.ftLastWriteTime, &newest) > 0) &&
+			load_baseline(candidate.c_str(), candidateSamples, &candidateIdentity) &&
+			candidateIdentity.signature == identity.signature && candidateIdentity.renderer == identity.renderer)
+		{
+			found = true;
+			newest = data.ftLastWriteTime;
+			path = candidate;
+			samples.swap(candidateSamples);
+			reference = candidateIdentity;
+		}
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+	return found;
+}
+
+static double median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	auto n = values.size();
+	return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) * 0.5;
+}
+
+/// <summary>
+/// Two-sided Mann-Whitney U test. Exact distribution for small samples
+/// without ties, normal approximation with tie correction otherwise.
+/// </summary>
+/// <returns>p-value</returns>
+static double mann_whitney(const std::vector<double>& a, const std::vector<double>& b)
+{
+	auto n1 = (int)a.size();
+	auto n2 = (int)b.size();
+	std::vector<std::pair<double, int>> all;
+	for (auto value : a)
+	{
+		all.push_back({ value, 0 });
+	}
+	for (auto value : b)
+	{
+		all.push_back({ value, 1 });
+	}
+	std::sort(all.begin(), all.end());
+	// Average ranks over ties
+	auto n = n1 + n2;
+	double rankSum = 0;
+	double tieTerm = 0;
+	for (int i = 0; i < n;)
+	{
+		auto j = i;
+		while (j + 1 < n && all[j + 1].first == all[i].first)
+		{
+			j++;
+		}
+		auto rank = (i + j) * 0.5 + 1;
+		for (int k = i; k <= j; k++)
+		{
+			if (all[k].second == 0)
+			{
+				rankSum += rank;
+			}
+		}
+		double t = j - i + 1;
+		tieTerm += t * t * t - t;
+		i = j + 1;
+	}
+	auto u = rankSum - n1 * (n1 + 1) * 0.5;
+	if (tieTerm == 0 && n1 <= 20 && n2 <= 20)
+	{
+		// count[m][u]: orderings of m samples of a among i of b giving U = u, built one b sample at a time
+		auto maxU = n1 * n2;
+		std::vector<std::vector<double>> count(n1 + 1, std::vector<double>(maxU + 1, 0));
+		for (int m = 0; m <= n1; m++)
+		{
+			count[m][0] = 1;
+		}
+		for (int i = 1; i <= n2; i++)
+		{
+			std::vector<std::vector<double>> next(n1 + 1, std::vector<double>(maxU + 1, 0));
+			next[0][0] = 1;
+			for (int m = 1; m <= n1; m++)
+			{
+				for (int v = 0; v <= m * i; v++)
+				{
+					// The largest value is either from b (U unchanged) or from a (beats all i samples of b)
+					next[m][v] = count[m][v] + (v >= i ? next[m - 1][v - i] : 0);
+				}
+			}
+			count.swap(next);
+		}
+		double total = 0;
+		double lower = 0;
+		for (int v = 0; v <= maxU; v++)
+		{
+			total += count[n1][v];
+			if (v <= u)
+			{
+				lower += count[n1][v];
+			}
+		}
+		double upper = total - lower + count[n1][(int)u];
+		return (std::min)(1.0, 2 * (std::min)(lower, upper) / total);
+	}
+	auto mean = n1 * n2 * 0.5;
+	auto variance = n1 * n2 / 12.0 * ((n + 1) - tieTerm / ((double)n * (n - 1)));
+	if (variance <= 0)
+	{
+		return 1;
+	}
+	auto z = (fabs(u - mean) - 0.5) / sqrt(variance);
+	return (std::min)(1.0, erfc((std::max)(z, 0.0) / sqrt(2.0)));
+}
+
+/// <summary>
+/// Percentile bootstrap of the relative change of the median, fixed seed so reports are reproducible
+/// </summary>
+static void bootstrap_ci(const std::vector<double>& baseline, const std::vector<double>& current, double& low, double& high)
+{
+	const int iterations = 2000;
+	std::mt19937 random(12345);
+	std::vector<double> changes(iterations);
+	std::vector<double> a(baseline.size());
+	std::vector<double> b(current.size());
+	std::uniform_int_distribution<size_t> pickA(0, baseline.size() - 1);
+	std::uniform_int_distribution<size_t> pickB(0, current.size() - 1);
+	for (int i = 0; i < iterations; i++)
+	{
+		for (auto& value : a)
+		{
+			value = baseline[pickA(random)];
+		}
+		for (auto& value : b)
+		{
+			value = current[pickB(random)];
+		}
+		auto reference = median(a);
+		changes[i] = reference != 0 ? median(b) / reference - 1 : 0;
+	}
+	std::sort(changes.begin(), changes.end());
+	low = changes[(size_t)(iterations * 0.025)];
+	high = changes[(size_t)(iterations * 0.975) - 1];
+}
+
+/// <summary>
+/// Compare the runs with the baseline and print one report line per series
+/// </summary>
+/// <returns>Number of regressions</returns>
+static int compare(const BenchOptions& options, const BenchSamples& baseline, const BenchSamples& current)
+{
+	auto regressions = 0;
+	printf("%-16s %10s %10s %8s %18s %8s\n", "metric", "baseline", "current", "change", "95% CI", "p");
+	for (auto& series : current)
+	{
+		auto reference = baseline.find(series.first);
+		if (reference == baseline.end() || reference->second.values.size() < 2 || series.second.values.size() < 2)
+		{
+			printf("%-16s %10s\n", series.first.c_str(), "new");
+			continue;
+		}
+		auto& a = reference->second.values;
+		auto& b = series.second.values;
+		auto reference_median = median(a);
+		auto change = reference_median != 0 ? median(b) / reference_median - 1 : 0;
+		auto p = mann_whitney(a, b);
+		double low = 0;
+		double high = 0;
+		bootstrap_ci(a, b, low, high);
+		// Worse means lower fps or longer frame times
+		auto sign = series.second.higherIsBetter ? -1 : 1;
+		auto significant = p < options.alpha && (low > 0 || high < 0);
+		auto regressed = significant && sign * change > options.threshold;
+		auto improved = significant && -sign * change > options.threshold;
+		printf("%-16s %10.3f %10.3f %+7.1f%% [%+6.1f%%, %+6.1f%%] %8.4f %s\n", series.first.c_str(),
+			reference_median, median(b), change * 100, low * 100, high * 100, p,
+			regressed ? "REGRESSION" : improved ? "improved" : "");
+		Log.v("%s: %+.1f%% p=%.4f%s", series.first.c_str(), change * 100, p, regressed ? " regression" : "");
+		if (regressed)
+		{
+			regressions++;
+		}
+	}
+	for (auto& series : baseline)
+	{
+		if (current.find(series.first) == current.end())
+		{
+			// A test that used to pass and no longer produces samples
+			printf("%-16s %10s REGRESSION\n", series.first.c_str(), "missing");
+			regressions++;
+		}
+	}
+	return regressions;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	if (!parse_options(argc, argv, options))
+	{
+		return BENCH_EXIT_ERROR;
+	}
+	auto suite = options.suite;
+	// One warm session for all the runs, the WAD and the pipeline cache are loaded once
+	oevSession session("GLVIEW.RMX", OEV_WAD_MAPPED);
+	if (!session.IsValid())
+	{
+		fprintf(stderr, "infogl.dll or GLVIEW.RMX not found\n");
+		return BENCH_EXIT_ERROR;
+	}
+	auto identity = get_identity(session, suite->renderer);
+	auto baselinePath = get_baseline_path(options, identity);
+	printf("Suite %s, %d run(s), CPU %s, renderer %s, driver %s\n", suite->name, options.runs,
+		identity.signature.c_str(), identity.renderer.c_str(), identity.driver.c_str());
+	auto tests = session.GetRunnableTests(suite->renderer);
+	if (tests.empty())
+	{
+		fprintf(stderr, "No runnable test for renderer %d\n", suite->renderer);
+		return BENCH_EXIT_ERROR;
+	}
+	std::vector<gvRenderingTestConfig> configs;
+	for (int i = 0; i < 4 && suite->multisample[i] >= 0; i++)
+	{
+		gvRenderingTestConfig config = {};
+		config.structSize = sizeof(config);
+		config.renderer = suite->renderer;
+		config.option = suite->option;
+		if (!(config.option & WGLDIAG_OPTION_HEADLESS))
+		{
+			static const oevDisplayModes displayModes;
+			config.displayMode = displayModes.Find(suite->width, suite->height);
+			if (config.displayMode == OEV_DISPLAYMODE_NOT_FOUND)
+			{
+				fprintf(stderr, "Display mode %dx%d not supported\n", suite->width, suite->height);
+				return BENCH_EXIT_ERROR;
+			}
+		}
+		config.fbformat = WGLDIAG_FB_sRGB;
+		config.duration = suite->duration;
+		config.multisample = suite->multisample[i];
+		config.anisotropy = 16;
+		config.pixelFormat = 1;
+		config.width = suite->width;
+		config.height = suite->height;
+		config.tests = tests.c_str();
+		config.scene = suite->scene;
+		config.objectCount = suite->objectCount;
+		config.drawModes = suite->drawModes;
+		config.streamBudget = suite->streamBudget;
+		config.streamQueueDepth = suite->streamQueueDepth;
+		config.fbformatMask = suite->fbformatMask;
+		config.multisampleMask = suite->multisampleMask;
+		config.pipelineCache = "glview_cache";
+		config.warmup = 2000;
+		config.warmupTolerance = 0.05f;
+		config.warmupWindow = 60;
+		config.telemetryInterval = 100;
+		configs.push_back(config);
+	}
+	std::unique_ptr<ResultWriter> writer;
+	if (options.resultsPath)
+	{
+		writer = ResultWriter::Open(options.resultsPath, ResultFormat::JsonLines, false);
+	}
+	BenchSamples samples;
+	for (int run = 0; run < options.runs; run++)
+	{
+		printf("Run %d/%d\n", run + 1, options.runs);
+		auto failed = run_suite(session, configs, samples, writer.get());
+		if (failed != 0)
+		{
+			// Partial samples would bias the comparison
+			if (failed < 0)
+			{
+				fprintf(stderr, "Run %d failed\n", run + 1);
+			}
+			else
+			{
+				fprintf(stderr, "%d test(s) failed in run %d\n", failed, run + 1);
+			}
+			return BENCH_EXIT_ERROR;
+		}
+	}
+	if (writer)
+	{
+		writer->Flush();
+	}
+	if (options.update)
+	{
+		CreateDirectoryA(options.baselineDir.c_str(), nullptr);
+		if (!save_baseline(baselinePath.c_str(), identity, samples))
+		{
+			fprintf(stderr, "Failed to write %s\n", baselinePath.c_str());
+			return BENCH_EXIT_ERROR;
+		}
+		printf("Baseline saved to %s\n", baselinePath.c_str());
+		return BENCH_EXIT_PASS;
+	}
+	BenchSamples baseline;
+	BenchIdentity reference;
+	if (!find_baseline(options, identity, baselinePath, baseline, reference))
+	{
+		printf("No baseline %s, run with --update first\n", baselinePath.c_str());
+		return BENCH_EXIT_NO_BASELINE;
+	}
+	if (reference.driver != identity.driver)
+	{
+		// Driver update: the new driver is gated against the samples of the previous one
+		printf("Comparing with driver %s, %s\n", reference.driver.c_str(), baselinePath.c_str());
+	}
+	auto regressions = compare(options, baseline, samples);
+	printf("%d regression(s)\n", regressions);
+	LogQueue::Get().Flush();
+	return regressions ? BENCH_EXIT_REGRESSION : BENCH_EXIT_PASS;
+}
@@ -0,0 +1,620 @@
+/****************************************************************************
+; *
+; * 	File		:	oevConfig.cpp
+; *
+; * 	Description :	Rendering test configurations from the command line and text files
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#include "oevConfig.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+
+static const char* const kRendererNames[MAX_RENDERER] =
+{
+	"gdi", "gl2.0", "gl3.0", "gl3.1", "gl3.2", "gl3.3", "gl4.0", "gl4.1", "gl4.2",
+	"gl4.3", "gl4.4", "gl4.5", "gl4.6", "vk1.0", "vk1.1", "vk1.2"
+};
+
+static const char* const kFbFormatNames[] = { "linear", "srgb", "hdr" };
+
+// Bit i is OEV_DRAW_*
+static const char* const kDrawModeNames[] = { "individual", "instanced", "mdi", "bindless" };
+
+static const struct
+{
+	const char* name;
+	int TestOptions::* field;
+	bool flag; // 0/1, true/false, on/off
+} kIntKeys[] =
+{
+	{ "debug", &TestOptions::debug, true },
+	{ "fullscreen", &TestOptions::fullscreen, true },
+	{ "width", &TestOptions::width, false },
+	{ "height", &TestOptions::height, false },
+	{ "vsync", &TestOptions::vsync, true },
+	{ "fog", &TestOptions::fog, true },
+	{ "transparency", &TestOptions::transparency, true },
+	{ "clip", &TestOptions::clipPlane, true },
+	{ "msaa", &TestOptions::multisampling, false },
+	{ "aniso", &TestOptions::anisotropy, false },
+	{ "lod", &TestOptions::textureLod, false },
+	{ "pixelformat", &TestOptions::pixelFormat, false },
+	{ "objects", &TestOptions::objects, false },
+	{ "budget", &TestOptions::streamBudget, false },
+	{ "depth", &TestOptions::streamQueueDepth, false },
+	{ "duration", &TestOptions::duration, false },
+	{ "headless", &TestOptions::headless, true },
+	{ "profile", &TestOptions::profile, true },
+	{ "latency", &TestOptions::latency, true },
+	{ "threads", &TestOptions::threads, false },
+	{ "warmup", &TestOptions::warmup, false },
+	{ "warmupwindow", &TestOptions::warmupWindow, false },
+	{ "mindur", &TestOptions::minDuration, false },
+	{ "telemetry", &TestOptions::telemetry, false },
+};
+
+static const struct
+{
+	const char* name;
+	float TestOptions::* field;
+} kFloatKeys[] =
+{
+	{ "warmuptol", &TestOptions::warmupTolerance },
+	{ "targetrse", &TestOptions::targetRse },
+};
+
+// Case insensitive, '_' matches '.' so gl4_6 and GL4.6 both work
+static bool equals(const std::string& value, const char* name)
+{
+	if (value.size() != strlen(name))
+	{
+		return false;
+	}
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		auto c = (char)tolower((unsigned char)value[i]);
+		if ((c == '_' ? '.' : c) != name[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool parse_int(const std::string& value, bool flag, int& out)
+{
+	if (flag)
+	{
+		if (equals(value, "true") || equals(value, "on"))
+		{
+			out = 1;
+			return true;
+		}
+		if (equals(value, "false") || equals(value, "off"))
+		{
+			out = 0;
+			return true;
+		}
+	}
+	char* end = nullptr;
+	auto n = strtol(value.c_str(), &end, 10);
+	if (value.empty() || *end || n < 0)
+	{
+		return false;
+	}
+	out = flag ? (n != 0) : (int)n;
+	return true;
+}
+
+static bool parse_float(const std::string& value, float& out)
+{
+	char* end = nullptr;
+	auto n = strtod(value.c_str(), &end);
+	if (value.empty() || *end || !(n >= 0))
+	{
+		return false;
+	}
+	out = (float)n;
+	return true;
+}
+
+static bool parse_index(const std::string& value, const char* const* names, int count, int& out)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (equals(value, names[i]))
+		{
+			out = i;
+			return true;
+		}
+	}
+	return parse_int(value, false, out) && out < count;
+}
+
+// Comma separated names, bit i is names[i]
+static bool parse_mask(const std::string& value, const char* const* names, int count, int& mask)
+{
+	mask = 0;
+	size_t start = 0;
+	while (start <= value.size())
+	{
+		auto end = value.find(',', start);
+		if (end == std::string::npos)
+		{
+			end = value.size();
+		}
+		auto name = value.substr(start, end - start);
+		auto index = 0;
+		while (index < count && !equals(name, names[index]))
+		{
+			index++;
+		}
+		if (index == count)
+		{
+			return false;
+		}
+		mask |= 1 << index;
+		start = end + 1;
+	}
+	return true;
+}
+
+static bool set_option(const std::string& key, const std::string& value, TestOptions& options)
+{
+	if (key == "renderer")
+	{
+		int renderer = 0;
+		if (!parse_index(value, kRendererNames, MAX_RENDERER, renderer))
+		{
+			return false;
+		}
+		options.renderer = (ovRenderer)renderer;
+		return true;
+	}
+	if (key == "fbformat")
+	{
+		return parse_index(value, kFbFormatNames, WGLDIAG_FB_HDR + 1, options.fbformat);
+	}
+	if (key == "scene")
+	{
+		if (equals(value, "drawcalls"))
+		{
+			options.scene = OEV_SCENE_DRAWCALLS;
+			return true;
+		}
+		if (equals(value, "streaming"))
+		{
+			options.scene = OEV_SCENE_STREAMING;
+			return true;
+		}
+		return parse_int(value, false, options.scene);
+	}
+	if (key == "drawmodes")
+	{
+		if (equals(value, "all"))
+		{
+			options.drawModes = OEV_DRAW_ALL;
+			return true;
+		}
+		return parse_int(value, false, options.drawModes) || parse_mask(value, kDrawModeNames, 4, options.drawModes);
+	}
+	if (key == "fbformats")
+	{
+		if (equals(value, "all"))
+		{
+			options.fbformatMask = OEV_FBFORMAT_ALL;
+			return true;
+		}
+		return parse_mask(value, kFbFormatNames, WGLDIAG_FB_HDR + 1, options.fbformatMask);
+	}
+	if (key == "msaalevels")
+	{
+		if (equals(value, "all"))
+		{
+			options.multisampleMask = OEV_MULTISAMPLE_ALL;
+			return true;
+		}
+		// Comma separated sample counts, 0 or 1 is no multisampling
+		options.multisampleMask = 0;
+		size_t start = 0;
+		while (start <= value.size())
+		{
+			auto end = value.find(',', start);
+			if (end == std::string::npos)
+			{
+				end = value.size();
+			}
+			int samples = 0;
+			if (!parse_int(value.substr(start, end - start), false, samples) || samples > 16 || (samples & (samples - 1)))
+			{
+				return false;
+			}
+			options.multisampleMask |= samples ? samples : 1;
+			start = end + 1;
+		}
+		return true;
+	}
+	if (key == "tests")
+	{
+		// ',' is accepted for shells, the SDK separates test ids with ';'
+		options.tests = value;
+		for (auto& c : options.tests)
+		{
+			c = c == ',' ? ';' : c;
+		}
+		return true;
+	}
+	if (key == "cache")
+	{
+		options.cache = value;
+		return true;
+	}
+	for (auto& intKey : kIntKeys)
+	{
+		if (key == intKey.name)
+		{
+			return parse_int(value, intKey.flag, options.*intKey.field);
+		}
+	}
+	for (auto& floatKey : kFloatKeys)
+	{
+		if (key == floatKey.name)
+		{
+			return parse_float(value, options.*floatKey.field);
+		}
+	}
+	return false;
+}
+
+// Split on spaces and tabs, double quotes group characters
+static std::vector<std::string> tokenize(const char* text)
+{
+	std::vector<std::string> tokens;
+	std::string token;
+	auto quoted = false;
+	auto pending = false;
+	for (auto p = text ? text : ""; *p; p++)
+	{
+		if (*p == '"')
+		{
+			quoted = !quoted;
+			pending = true;
+		}
+		else if (!quoted && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+		{
+			if (pending)
+			{
+				tokens.push_back(token);
+				token.clear();
+				pending = false;
+			}
+		}
+		else
+		{
+			token += *p;
+			pending = true;
+		}
+	}
+	if (pending)
+	{
+		tokens.push_back(token);
+	}
+	return tokens;
+}
+
+static bool apply_token(const std::string& token, TestOptions& options, std::string& error)
+{
+	auto equal = token.find('=');
+	if (equal == std::string::npos || equal == 0)
+	{
+		error = "expected key=value: " + token;
+		return false;
+	}
+	auto key = token.substr(0, equal);
+	for (auto& c : key)
+	{
+		c = (char)tolower((unsigned char)c);
+	}
+	if (!set_option(key, token.substr(equal + 1), options))
+	{
+		error = "bad option: " + token;
+		return false;
+	}
+	return true;
+}
+
+bool ParseTestOptions(const char* text, TestOptions& options, std::string& error)
+{
+	for (auto& token : tokenize(text))
+	{
+		if (!apply_token(token, options, error))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+std::string FormatTestOptions(const TestOptions& options)
+{
+	std::string text = "renderer=";
+	text += options.renderer >= 0 && options.renderer < MAX_RENDERER ? kRendererNames[options.renderer] : "0";
+	text += " fbformat=" + std::to_string(options.fbformat);
+	text += " scene=" + std::to_string(options.scene);
+	text += " drawmodes=" + std::to_string(options.drawModes);
+	for (auto& intKey : kIntKeys)
+	{
+		text += ' ';
+		text += intKey.name;
+		text += '=' + std::to_string(options.*intKey.field);
+	}
+	for (auto& floatKey : kFloatKeys)
+	{
+		char value[32];
+		snprintf(value, sizeof(value), "%g", options.*floatKey.field);
+		text += ' ';
+		text += floatKey.name;
+		text += '=';
+		text += value;
+	}
+	if (options.fbformatMask)
+	{
+		auto separator = " fbformats=";
+		for (int i = 0; i <= WGLDIAG_FB_HDR; i++)
+		{
+			if (options.fbformatMask & (1 << i))
+			{
+				text += separator;
+				text += kFbFormatNames[i];
+				separator = ",";
+			}
+		}
+	}
+	if (options.multisampleMask)
+	{
+		auto separator = " msaalevels=";
+		for (int samples = 1; samples <= 16; samples <<= 1)
+		{
+			if (options.multisampleMask & samples)
+			{
+				text += separator + std::to_string(samples == 1 ? 0 : samples);
+				separator = ",";
+			}
+		}
+	}
+	if (!options.tests.empty())
+	{
+		text += " tests=" + options.tests;
+	}
+	// Quoted, the directory may contain spaces, and cache="" disables it
+	text += " cache=\"" + options.cache + '"';
+	return text;
+}
+
+bool LoadTestOptions(const char* path, const TestOptions& defaults, std::vector<TestOptions>& list, std::string& error)
+{
+	auto handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		error = std::string("cannot open ") + path;
+		return false;
+	}
+	LineReader reader(handle);
+	std::string line;
+	auto ok = true;
+	for (int number = 1; ok && reader.ReadLine(line); number++)
+	{
+		auto comment = line.find('#');
+		if (comment != std::string::npos)
+		{
+			line.resize(comment);
+		}
+		if (line.find_first_not_of(" \t") == std::string::npos)
+		{
+			continue;
+		}
+		auto options = defaults;
+		ok = ParseTestOptions(line.c_str(), options, error);
+		if (ok)
+		{
+			list.push_back(options);
+		}
+		else
+		{
+			error = std::string(path) + "(" + std::to_string(number) + "): " + error;
+		}
+	}
+	CloseHandle(handle);
+	return ok;
+}
+
+bool ParseCommandLine(const char* lpCmdLine, CommandLine& commandLine, std::string& error)
+{
+	auto tokens = tokenize(lpCmdLine);
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		auto& token = tokens[i];
+		auto hasValue = i + 1 < tokens.size() && tokens[i + 1].compare(0, 2, "--") != 0;
+		if (token == "--config" && hasValue)
+		{
+			commandLine.configFiles.push_back(tokens[++i]);
+		}
+		else if (token == "--serve")
+		{
+			commandLine.serve = true;
+			// Optional pipe name, key=value tokens are not pipe names
+			if (hasValue && tokens[i + 1].find('=') == std::string::npos)
+			{
+				commandLine.servePipe = tokens[++i];
+			}
+		}
+		else if (token == "--listen" && hasValue)
+		{
+			commandLine.listenPort = atoi(tokens[++i].c_str());
+			if (commandLine.listenPort <= 0 || commandLine.listenPort > 65535)
+			{
+				error = "bad port " + tokens[i];
+				return false;
+			}
+		}
+		else if (token == "--bind" && hasValue)
+		{
+			commandLine.bind = tokens[++i];
+		}
+		else if (token == "--token" && hasValue)
+		{
+			commandLine.token = tokens[++i];
+		}
+		else if (token == "--results" && hasValue)
+		{
+			commandLine.results = tokens[++i];
+		}
+		else if (token == "--format" && hasValue)
+		{
+			auto& format = tokens[++i];
+			if (format == "json")
+			{
+				commandLine.format = ResultFormat::JsonLines;
+			}
+			else if (format == "csv")
+			{
+				commandLine.format = ResultFormat::Csv;
+			}
+			else if (format == "binary")
+			{
+				commandLine.format = ResultFormat::Binary;
+			}
+			else
+			{
+				error = "unknown format " + format;
+				return false;
+			}
+		}
+		else if (token == "--trace")
+		{
+			// ETW only without a path, for xperf / WPR sessions
+			commandLine.traceFlags = OEV_TRACE_ETW;
+			if (hasValue && tokens[i + 1].find('=') == std::string::npos)
+			{
+				commandLine.trace = tokens[++i];
+				commandLine.traceFlags |= OEV_TRACE_RING;
+			}
+		}
+		else if (token == "--workers")
+		{
+			commandLine.workers = -1;
+			if (hasValue && tokens[i + 1].find('=') == std::string::npos)
+			{
+				commandLine.workers = atoi(tokens[++i].c_str());
+				if (commandLine.workers <= 0)
+				{
+					error = "bad worker count " + tokens[i];
+					return false;
+				}
+			}
+		}
+		else if (token == "--worker-timeout" && hasValue)
+		{
+			commandLine.workerTimeout = atoi(tokens[++i].c_str());
+			if (commandLine.workerTimeout <= 0)
+			{
+				error = "bad worker timeout " + tokens[i];
+				return false;
+			}
+		}
+		else if (token == "--worker" && hasValue)
+		{
+			commandLine.workerChannel = tokens[++i];
+		}
+		else if (token == "--log" && hasValue)
+		{
+			commandLine.log = tokens[++i];
+		}
+		else if (token == "--log-level" && hasValue)
+		{
+			static const char* const levels[] = { "verbose", "info", "error", "none" };
+			int level = 0;
+			if (!parse_index(tokens[++i], levels, LOG_NONE + 1, level))
+			{
+				error = "unknown log level " + tokens[i];
+				return false;
+			}
+			commandLine.logLevel = (LogLevel)level;
+		}
+		else if (token == "--single-adapter")
+		{
+			commandLine.allAdapters = false;
+		}
+		else if (token.compare(0, 2, "--") == 0)
+		{
+			error = "unknown or incomplete option " + token;
+			return false;
+		}
+		else if (apply_token(token, commandLine.defaults, error))
+		{
+			commandLine.hasOptions = true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+LineReader::LineReader(HANDLE handle) :
+	source([handle](char* buffer, int size)
+	{
+		DWORD n = 0;
+		// ERROR_BROKEN_PIPE when the client disconnected
+		return ReadFile(handle, buffer, (DWORD)size, &n, nullptr) ? (int)n : 0;
+	})
+{
+}
+bool LineReader::ReadLine(std::string& line)
+{
+	for (;;)
+	{
+		auto end = buffer.find('\n', offset);
+		if (end != std::string::npos || (eof && offset < buffer.size()))
+		{
+			if (end == std::string::npos)
+			{
+				end = buffer.size();
+			}
+			line.assign(buffer, offset, end - offset);
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+			offset = end + 1;
+			return true;
+		}
+		if (eof)
+		{
+			return false;
+		}
+		buffer.erase(0, offset);
+		offset = 0;
+		char chunk[4096];
+		auto n = source(chunk, (int)sizeof(chunk));
+		if (n <= 0)
+		{
+			eof = true;
+			continue;
+		}
+		buffer.append(chunk, n);
+	}
+}
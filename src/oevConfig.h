@@ -0,0 +1,148 @@
+/****************************************************************************
+; *
+; * 	File		:	oevConfig.h
+; *
+; * 	Description :	Rendering test configurations from the command line and text files
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <Windows.h>
+#include "include/oevSDK.h"
+#include "oevResultWriter.h"
+#include "oevLog.h"
+
+/// <summary>
+/// Settings of one configuration, as key=value tokens:
+/// renderer=gl4.6 width=1920 height=1080 msaa=4 aniso=16 lod=0 pixelformat=1 scene=0
+/// fbformat=srgb duration=20 fullscreen=0 vsync=0 fog=0 transparency=0 clip=0
+/// debug=0 headless=0 profile=0 latency=0 threads=0 tests=3.0;4.5
+/// cache=glview_cache, cache= to compile every pipeline
+/// warmup=2000 warmuptol=0.05 warmupwindow=60, warmup=0 to measure from the first frame
+/// targetrse=0.005 mindur=2000 to stop before duration once the mean frame time is stable
+/// telemetry=100 samples clocks, temperatures and power every 100 ms
+/// scene=drawcalls objects=10000 drawmodes=individual,instanced,mdi,bindless
+/// scene=streaming budget=256 depth=4
+/// fbformats=linear,srgb,hdr or all, msaalevels=0,4,8 or all: every combination in one session
+/// </summary>
+struct TestOptions
+{
+	ovRenderer renderer = RENDERER_VK1_2;
+	int debug = 0;
+	int fullscreen = 0;
+	int width = 1920;
+	int height = 1080;
+	int vsync = 0;
+	int fog = 0;
+	int transparency = 0;
+	int clipPlane = 0;
+	int multisampling = 8; // Samples, as the original sample
+	int anisotropy = 16;
+	int textureLod = 0;
+	int pixelFormat = 1;
+	int scene = 0;
+	int fbformat = WGLDIAG_FB_sRGB;
+	int duration = 20;
+	int headless = 0;
+	int profile = 0; // WGLDIAG_OPTION_PROFILE, the timestamp queries perturb the frame times
+	int latency = 0; // WGLDIAG_OPTION_LATENCY
+	int threads = 0; // WGLDIAG_OPTION_MPENGINE worker threads, 0 to disable
+	int objects = 0; // scene=drawcalls object count, 0 for the default
+	int drawModes = 0; // OEV_DRAW_* mask, drawmodes=individual,instanced,mdi,bindless or all
+	int streamBudget = 0; // scene=streaming staging MB, 0 for the default
+	int streamQueueDepth = 0; // scene=streaming uploads in flight, 0 for the default
+	int fbformatMask = 0; // OEV_FBFORMAT_BIT mask, 0 runs fbformat only
+	int multisampleMask = 0; // Sample counts or'ed together, 1 is no multisampling, 0 runs multisampling only
+	int warmup = 2000; // Milliseconds at most, skips shader compilation, uploads and clock ramp-up
+	float warmupTolerance = 0.05f; // Relative standard deviation of the frame times ending the warm-up
+	int warmupWindow = 60; // Frames
+	float targetRse = 0; // Relative standard error of the mean frame time ending the run, 0 runs for duration
+	int minDuration = 0; // Milliseconds measured at least when targetRse is set
+	int telemetry = 0; // Sampling interval in milliseconds, 0 to disable
+	std::string tests; // Empty: every test the renderer and its driver can run
+	std::string cache = "glview_cache"; // gvRenderingTestConfig::pipelineCache directory, empty to disable
+};
+
+struct CommandLine
+{
+	TestOptions defaults; // key=value tokens, also the defaults of the configuration files
+	bool hasOptions = false; // Without key=value tokens or --config files, the run is msaa=0, 4 and 8 with the defaults
+	std::vector<std::string> configFiles; // --config path, one configuration per line
+	bool serve = false; // --serve [\\.\pipe\name], stdin when no pipe is given
+	std::string servePipe;
+	int listenPort = 0; // --listen port, remote agent, see oevAgent.h
+	std::string bind = "127.0.0.1"; // --bind address of --listen, 0.0.0.0 for every interface
+	std::string token; // --token secret, first line the --listen clients must send
+	std::string results = "glview_results.jsonl"; // --results path, "-" for stdout
+	ResultFormat format = ResultFormat::JsonLines; // --format json|csv|binary
+	bool allAdapters = true; // --single-adapter to disable
+	int traceFlags = 0; // --trace [path], OEV_TRACE_ETW, and OEV_TRACE_RING with a path
+	std::string trace; // Chrome trace JSON written at exit
+	int workers = 0; // --workers [N], isolated worker processes, see oevPool.h. -1 for one per hardware thread
+	int workerTimeout = 900; // --worker-timeout seconds, a configuration running longer is treated as a hung driver
+	std::string workerChannel; // --worker name, set by the pool on its child processes
+	std::string log; // --log path, the messages are also appended to the file
+	LogLevel logLevel = LOG_INFO; // --log-level verbose|info|error|none
+};
+
+/// <summary>
+/// Apply key=value tokens on top of options
+/// </summary>
+/// <param name="text">Tokens separated by spaces</param>
+/// <param name="options"></param>
+/// <param name="error">Set on failure</param>
+/// <returns>false on an unknown key or a bad value</returns>
+bool ParseTestOptions(const char* text, TestOptions& options, std::string& error);
+
+/// <summary>
+/// key=value tokens of every setting, ParseTestOptions gives the same options back
+/// </summary>
+std::string FormatTestOptions(const TestOptions& options);
+
+/// <summary>
+/// Read a configuration file, one configuration per line, '#' starts a comment
+/// </summary>
+/// <param name="path"></param>
+/// <param name="defaults">Settings of the keys not given on a line</param>
+/// <param name="list">Receives the configurations</param>
+/// <param name="error">Set on failure, with the line number</param>
+/// <returns></returns>
+bool LoadTestOptions(const char* path, const TestOptions& defaults, std::vector<TestOptions>& list, std::string& error);
+
+/// <summary>
+/// Parse WinMain lpCmdLine, double quotes group tokens containing spaces
+/// </summary>
+bool ParseCommandLine(const char* lpCmdLine, CommandLine& commandLine, std::string& error);
+
+// Reads up to size bytes, returns 0 at the end of the stream
+typedef std::function<int(char* buffer, int size)> LineSource;
+
+/// <summary>
+/// Blocking line reader over a file, a pipe, stdin or a socket
+/// </summary>
+class LineReader
+{
+public:
+	explicit LineReader(HANDLE handle);
+	explicit LineReader(LineSource source) : source(std::move(source)) {}
+	// false at the end of the stream or when the writer disconnected
+	bool ReadLine(std::string& line);
+
+private:
+	LineSource source;
+	std::string buffer;
+	size_t offset = 0;
+	bool eof = false;
+};
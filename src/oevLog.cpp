@@ -0,0 +1,166 @@
+/****************************************************************************
+; *
+; * 	File		:	oevLog.cpp
+; *
+; * 	Description :	Asynchronous logging
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#include "oevLog.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static const char* const kPrefixes[] = { "[VERBOSE] ", "[INFO] ", "[ERROR] " };
+
+LogQueue& LogQueue::Get()
+{
+	static LogQueue queue;
+	return queue;
+}
+LogQueue::LogQueue()
+{
+	slots = new Slot[kCapacity];
+	for (size_t i = 0; i < kCapacity; i++)
+	{
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	wake = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+	thread = std::thread(&LogQueue::Run, this);
+}
+LogQueue::~LogQueue()
+{
+	stopping.store(true);
+	SetEvent(wake);
+	thread.join();
+	CloseHandle(wake);
+	delete[] slots;
+}
+void LogQueue::SetOutput(HANDLE handle)
+{
+	Flush();
+	output.store(handle);
+}
+void LogQueue::Write(LogLevel level, const char* format, va_list argptr)
+{
+	// Formatting happens on the calling thread, without any shared state
+	thread_local char szTextBuffer[4096];
+	auto n = vsnprintf(szTextBuffer, sizeof(szTextBuffer), format, argptr);
+	if (n < 0)
+	{
+		return;
+	}
+	size_t length = (size_t)n < sizeof(szTextBuffer) ? (size_t)n : sizeof(szTextBuffer) - 1;
+	auto pos = enqueuePos.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;)
+	{
+		slot = &slots[pos & (kCapacity - 1)];
+		auto sequence = slot->sequence.load(std::memory_order_acquire);
+		auto diff = (intptr_t)sequence - (intptr_t)pos;
+		if (diff == 0)
+		{
+			if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// Full, never stall the caller
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+	if (length >= kTextSize)
+	{
+		length = kTextSize - 1;
+		memcpy(slot->text, szTextBuffer, length - 3);
+		memcpy(slot->text + length - 3, "...", 3);
+	}
+	else
+	{
+		memcpy(slot->text, szTextBuffer, length);
+	}
+	slot->text[length] = 0;
+	slot->length = (unsigned)length;
+	slot->level = level;
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	if (sleeping.exchange(false))
+	{
+		SetEvent(wake);
+	}
+}
+void LogQueue::Flush()
+{
+	auto target = enqueuePos.load();
+	while (written.load() < target)
+	{
+		SetEvent(wake);
+		Sleep(1);
+	}
+}
+void LogQueue::Run()
+{
+	std::string batch;
+	for (;;)
+	{
+		auto count = 0;
+		for (;;)
+		{
+			auto slot = &slots[dequeuePos & (kCapacity - 1)];
+			if (slot->sequence.load(std::memory_order_acquire) != dequeuePos + 1)
+			{
+				break;
+			}
+			// One call per message, the debugger channel is slow
+			std::string line = kPrefixes[slot->level];
+			line.append(slot->text, slot->length);
+			line += '\n';
+			slot->sequence.store(dequeuePos + kCapacity, std::memory_order_release);
+			dequeuePos++;
+			OutputDebugStringA(line.c_str());
+			batch += line;
+			count++;
+		}
+		auto handle = output.load();
+		if (!batch.empty() && handle != INVALID_HANDLE_VALUE)
+		{
+			DWORD n = 0;
+			WriteFile(handle, batch.data(), (DWORD)batch.size(), &n, nullptr);
+		}
+		batch.clear();
+		if (count)
+		{
+			written.fetch_add(count);
+			continue;
+		}
+		if (stopping.load())
+		{
+			break;
+		}
+		sleeping.store(true);
+		// Recheck after publishing the sleeping state, a producer might have missed it
+		auto slot = &slots[dequeuePos & (kCapacity - 1)];
+		if (slot->sequence.load(std::memory_order_acquire) == dequeuePos + 1)
+		{
+			sleeping.store(false);
+			continue;
+		}
+		WaitForSingleObject(wake, 50);
+		sleeping.store(false);
+	}
+}
@@ -0,0 +1,118 @@
+/****************************************************************************
+; *
+; * 	File		:	oevLog.h
+; *
+; * 	Description :	Asynchronous logging
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#pragma once
+#include <atomic>
+#include <thread>
+#include <stdarg.h>
+#include <Windows.h>
+
+enum LogLevel
+{
+	LOG_VERBOSE,
+	LOG_INFO,
+	LOG_ERROR,
+	LOG_NONE
+};
+
+/// <summary>
+/// Messages are formatted in a per-thread buffer and pushed to a lock-free
+/// multiple producers / single consumer ring. A background thread sends them
+/// to OutputDebugString and to an optional file. Producers never block: when
+/// the ring is full the message is dropped and counted.
+/// </summary>
+class LogQueue
+{
+public:
+	static LogQueue& Get();
+
+	bool IsEnabled(LogLevel level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+	void SetLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+	// Also write to a file, INVALID_HANDLE_VALUE to stop. The handle is not closed
+	void SetOutput(HANDLE handle);
+	void Write(LogLevel level, const char* format, va_list argptr);
+	// Wait until all the pushed messages have been written
+	void Flush();
+	unsigned long long GetDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+	~LogQueue();
+
+private:
+	LogQueue();
+	LogQueue(const LogQueue&) = delete;
+	LogQueue& operator=(const LogQueue&) = delete;
+	void Run();
+
+	static const size_t kCapacity = 1024; // Power of two
+	static const size_t kTextSize = 1024;
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		LogLevel level;
+		unsigned length;
+		char text[kTextSize];
+	};
+	Slot* slots;
+	alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+	alignas(64) size_t dequeuePos = 0;
+	std::atomic<size_t> written{ 0 };
+	std::atomic<unsigned long long> dropped{ 0 };
+	std::atomic<int> minLevel{ LOG_INFO }; // Log.d is off by default
+	std::atomic<bool> sleeping{ false };
+	std::atomic<bool> stopping{ false };
+	std::atomic<HANDLE> output{ INVALID_HANDLE_VALUE };
+	HANDLE wake;
+	std::thread thread;
+};
+
+class DebugLog
+{
+public:
+	void v(const char* format, ...)
+	{
+		auto& queue = LogQueue::Get();
+		if (queue.IsEnabled(LOG_INFO))
+		{
+			va_list argptr;
+			va_start(argptr, format);
+			queue.Write(LOG_INFO, format, argptr);
+			va_end(argptr);
+		}
+	}
+	void d(const char* format, ...)
+	{
+		auto& queue = LogQueue::Get();
+		if (queue.IsEnabled(LOG_VERBOSE))
+		{
+			va_list argptr;
+			va_start(argptr, format);
+			queue.Write(LOG_VERBOSE, format, argptr);
+			va_end(argptr);
+		}
+	}
+	void e(const char* format, ...)
+	{
+		auto& queue = LogQueue::Get();
+		if (queue.IsEnabled(LOG_ERROR))
+		{
+			va_list argptr;
+			va_start(argptr, format);
+			queue.Write(LOG_ERROR, format, argptr);
+			va_end(argptr);
+		}
+	}
+};
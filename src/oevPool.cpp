@@ -0,0 +1,427 @@
+/****************************************************************************
+; *
+; * 	File		:	oevPool.cpp
+; *
+; * 	Description :	Process isolated test runners
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#include "oevPool.h"
+#include <deque>
+#include <algorithm>
+#include <string.h>
+#include "oevLog.h"
+
+static DebugLog Log;
+
+enum PoolWorkerState
+{
+	POOL_WORKER_STARTING,
+	POOL_WORKER_READY, // Session loaded, waiting for a job
+	POOL_WORKER_BUSY, // Job in request
+	POOL_WORKER_DONE, // status set, all the output is in the ring
+	POOL_WORKER_EXIT
+};
+
+#define POOL_CHANNEL_MAGIC 0x4c4f4f50 // "POOL"
+
+static const size_t kRequestSize = 16 * 1024;
+static const size_t kRingSize = 1024 * 1024;
+
+// Shared memory of one worker
+struct PoolChannel
+{
+	DWORD magic;
+	DWORD parentPid;
+	int slot; // RunnerPool worker index, stable across restarts
+	volatile LONG state; // PoolWorkerState
+	volatile LONG status; // Job return value
+	int job;
+	char request[kRequestSize]; // FormatTestOptions, null terminated
+	// Single producer (worker) / single consumer (pool) byte ring, monotonic positions
+	volatile LONG64 written;
+	volatile LONG64 read;
+	char output[kRingSize];
+};
+
+static std::string get_channel_name(DWORD pid, int slot, int generation, const char* suffix)
+{
+	return "Local\\GLViewPool_" + std::to_string(pid) + "_" + std::to_string(slot) + "_" + std::to_string(generation) + suffix;
+}
+
+// Move the bytes available in the ring to out
+static void drain(PoolChannel* channel, std::string& out)
+{
+	auto written = InterlockedCompareExchange64(&channel->written, 0, 0);
+	auto read = channel->read;
+	auto start = read;
+	while (read < written)
+	{
+		auto offset = (size_t)(read % kRingSize);
+		auto chunk = (std::min)((size_t)(written - read), kRingSize - offset);
+		out.append(channel->output + offset, chunk);
+		read += chunk;
+	}
+	if (read != start)
+	{
+		InterlockedExchangeAdd64(&channel->read, read - start);
+	}
+}
+
+RunnerPool::RunnerPool(int workerCount, int timeoutSeconds, const std::string& workerArguments) :
+	workers((size_t)(std::max)(1, (std::min)(workerCount, MAXIMUM_WAIT_OBJECTS / 2))),
+	timeoutSeconds(timeoutSeconds),
+	workerArguments(workerArguments)
+{
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].slot = (int)i;
+	}
+}
+RunnerPool::~RunnerPool()
+{
+	for (auto& worker : workers)
+	{
+		Close(worker, true);
+	}
+}
+bool RunnerPool::Start()
+{
+	auto started = 0;
+	for (auto& worker : workers)
+	{
+		started += Spawn(worker) ? 1 : 0;
+	}
+	Log.v("Pool: %d worker(s) started", started);
+	return started > 0;
+}
+bool RunnerPool::Spawn(Worker& worker)
+{
+	worker.generation++;
+	auto pid = GetCurrentProcessId();
+	auto name = get_channel_name(pid, worker.slot, worker.generation, "");
+	worker.mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(PoolChannel), name.c_str());
+	worker.channel = worker.mapping ? (PoolChannel*)MapViewOfFile(worker.mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(PoolChannel)) : nullptr;
+	worker.request = CreateEventA(nullptr, FALSE, FALSE, get_channel_name(pid, worker.slot, worker.generation, "_request").c_str());
+	worker.notify = CreateEventA(nullptr, FALSE, FALSE, get_channel_name(pid, worker.slot, worker.generation, "_notify").c_str());
+	if (!worker.channel || !worker.request || !worker.notify)
+	{
+		Log.e("Pool: cannot create the channel of worker %d", worker.slot);
+		Close(worker, false);
+		return false;
+	}
+	worker.channel->magic = POOL_CHANNEL_MAGIC;
+	worker.channel->parentPid = pid;
+	worker.channel->slot = worker.slot;
+	worker.channel->state = POOL_WORKER_STARTING;
+	worker.channel->written = 0;
+	worker.channel->read = 0;
+	char path[MAX_PATH] = {};
+	GetModuleFileNameA(nullptr, path, MAX_PATH);
+	auto commandLine = "\"" + std::string(path) + "\" --worker " + name + " " + workerArguments;
+	std::vector<char> buffer(commandLine.begin(), commandLine.end());
+	buffer.push_back(0);
+	STARTUPINFOA startup = {};
+	startup.cb = sizeof(startup);
+	PROCESS_INFORMATION info = {};
+	// Same working directory, infogl.dll and GLVIEW.RMX are found the same way
+	if (!CreateProcessA(nullptr, buffer.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info))
+	{
+		Log.e("Pool: cannot start worker %d (%lu)", worker.slot, GetLastError());
+		Close(worker, false);
+		return false;
+	}
+	CloseHandle(info.hThread);
+	worker.process = info.hProcess;
+	worker.ready = false;
+	worker.job = -1;
+	worker.staged.clear();
+	return true;
+}
+void RunnerPool::Close(Worker& worker, bool wait)
+{
+	if (worker.process)
+	{
+		if (wait && worker.channel)
+		{
+			InterlockedExchange(&worker.channel->state, POOL_WORKER_EXIT);
+			SetEvent(worker.request);
+		}
+		if (!wait || WaitForSingleObject(worker.process, 5000) != WAIT_OBJECT_0)
+		{
+			TerminateProcess(worker.process, 1);
+		}
+		CloseHandle(worker.process);
+		worker.process = nullptr;
+	}
+	if (worker.channel)
+	{
+		UnmapViewOfFile(worker.channel);
+		worker.channel = nullptr;
+	}
+	for (auto handle : { &worker.mapping, &worker.request, &worker.notify })
+	{
+		if (*handle)
+		{
+			CloseHandle(*handle);
+			*handle = nullptr;
+		}
+	}
+	worker.ready = false;
+}
+int RunnerPool::Run(const std::vector<PoolJob>& jobs, ResultWriter* writer)
+{
+	std::deque<int> queue;
+	for (int i = 0; i < (int)jobs.size(); i++)
+	{
+		queue.push_back(i);
+	}
+	std::vector<int> attempts(jobs.size(), 0);
+	auto gpuBusy = false;
+	auto running = 0;
+	auto ret = 0;
+	auto finish = [&](Worker& worker)
+	{
+		if (!jobs[worker.job].concurrent)
+		{
+			gpuBusy = false;
+		}
+		worker.job = -1;
+		worker.staged.clear();
+		running--;
+	};
+	while (!queue.empty() || running > 0)
+	{
+		auto alive = 0;
+		for (auto& worker : workers)
+		{
+			alive += worker.process ? 1 : 0;
+			if (!worker.ready || worker.job >= 0)
+			{
+				continue;
+			}
+			// A GPU job runs alone, software renderers next to it would skew its CPU timings.
+			// Jobs start in order: a GPU job waits for the running ones instead of being starved
+			if (queue.empty() || gpuBusy || (!jobs[queue.front()].concurrent && running > 0))
+			{
+				continue;
+			}
+			auto job = queue.front();
+			queue.pop_front();
+			if (jobs[job].options.size() >= kRequestSize)
+			{
+				Log.e("Pool: job %d too long", job);
+				if (writer)
+				{
+					writer->WriteEvent("failed", job, -8);
+				}
+				ret = -8;
+				continue;
+			}
+			memcpy(worker.channel->request, jobs[job].options.c_str(), jobs[job].options.size() + 1);
+			worker.channel->job = job;
+			worker.job = job;
+			worker.jobStart = GetTickCount64();
+			gpuBusy = gpuBusy || !jobs[job].concurrent;
+			running++;
+			InterlockedExchange(&worker.channel->state, POOL_WORKER_BUSY);
+			SetEvent(worker.request);
+		}
+		if (alive == 0)
+		{
+			Log.e("Pool: no worker left, %d job(s) not run", (int)queue.size());
+			for (auto job : queue)
+			{
+				if (writer)
+				{
+					writer->WriteEvent("failed", job, -3);
+				}
+			}
+			return -3;
+		}
+		std::vector<HANDLE> handles;
+		for (auto& worker : workers)
+		{
+			if (worker.process)
+			{
+				handles.push_back(worker.notify);
+				handles.push_back(worker.process);
+			}
+		}
+		WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, 100);
+		for (auto& worker : workers)
+		{
+			if (!worker.process)
+			{
+				continue;
+			}
+			drain(worker.channel, worker.staged);
+			auto state = InterlockedCompareExchange(&worker.channel->state, 0, 0);
+			if (!worker.ready && state == POOL_WORKER_READY)
+			{
+				worker.ready = true;
+				worker.startFailures = 0;
+				worker.staged.clear();
+				Log.v("Pool: worker %d ready", worker.slot);
+			}
+			if (worker.job >= 0 && state == POOL_WORKER_DONE)
+			{
+				// The state is set after the last byte, nothing more is coming
+				drain(worker.channel, worker.staged);
+				if (writer && !worker.staged.empty())
+				{
+					writer->WriteRaw(worker.staged.data(), worker.staged.size());
+				}
+				if (worker.channel->status != 0)
+				{
+					ret = worker.channel->status;
+				}
+				finish(worker);
+				InterlockedExchange(&worker.channel->state, POOL_WORKER_READY);
+				continue;
+			}
+			auto exited = WaitForSingleObject(worker.process, 0) == WAIT_OBJECT_0;
+			auto hung = !exited && worker.job >= 0 && GetTickCount64() - worker.jobStart > (ULONGLONG)timeoutSeconds * 1000;
+			if (!exited && !hung)
+			{
+				continue;
+			}
+			DWORD exitCode = 0;
+			if (hung)
+			{
+				Log.e("Pool: worker %d timed out on job %d", worker.slot, worker.job);
+				TerminateProcess(worker.process, (UINT)WAIT_TIMEOUT);
+				WaitForSingleObject(worker.process, 5000);
+			}
+			GetExitCodeProcess(worker.process, &exitCode);
+			if (worker.job >= 0)
+			{
+				auto job = worker.job;
+				Log.e("Pool: worker %d exited with 0x%08lx during job %d, attempt %d", worker.slot, exitCode, job, attempts[job] + 1);
+				if (writer)
+				{
+					writer->WriteEvent("crashed", job, (int)exitCode);
+				}
+				finish(worker);
+				if (++attempts[job] < kMaxAttempts)
+				{
+					queue.push_front(job);
+				}
+				else
+				{
+					if (writer)
+					{
+						writer->WriteEvent("failed", job, -10);
+					}
+					ret = -10;
+				}
+			}
+			else if (!worker.ready)
+			{
+				Log.e("Pool: worker %d failed to start (0x%08lx)", worker.slot, exitCode);
+				worker.startFailures++;
+			}
+			Close(worker, false);
+			if (worker.startFailures < kMaxAttempts)
+			{
+				Spawn(worker);
+			}
+		}
+	}
+	return ret;
+}
+
+int RunPoolWorker(const char* channelName, ResultFormat format, const PoolJobHandler& handler)
+{
+	std::string name(channelName);
+	auto mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+	auto channel = mapping ? (PoolChannel*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(PoolChannel)) : nullptr;
+	auto request = OpenEventA(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, (name + "_request").c_str());
+	auto notify = OpenEventA(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, (name + "_notify").c_str());
+	auto parent = channel && channel->magic == POOL_CHANNEL_MAGIC ? OpenProcess(SYNCHRONIZE, FALSE, channel->parentPid) : nullptr;
+	auto ret = -9;
+	if (channel && request && notify && parent)
+	{
+		// Blocks while the ring is full, gives up if the pool went away
+		auto writer = ResultWriter::Open([channel, notify, parent](const char* data, size_t size)
+		{
+			while (size > 0)
+			{
+				auto written = channel->written;
+				auto space = kRingSize - (size_t)(written - InterlockedCompareExchange64(&channel->read, 0, 0));
+				if (space == 0)
+				{
+					SetEvent(notify);
+					if (WaitForSingleObject(parent, 1) == WAIT_OBJECT_0)
+					{
+						return false;
+					}
+					continue;
+				}
+				auto offset = (size_t)(written % kRingSize);
+				auto chunk = (std::min)(size, (std::min)(space, kRingSize - offset));
+				memcpy(channel->output + offset, data, chunk);
+				// Full barrier, the bytes are visible before the new position
+				InterlockedExchangeAdd64(&channel->written, (LONG64)chunk);
+				data += chunk;
+				size -= chunk;
+			}
+			SetEvent(notify);
+			return true;
+		}, format, true, false);
+		InterlockedExchange(&channel->state, POOL_WORKER_READY);
+		SetEvent(notify);
+		HANDLE handles[] = { request, parent };
+		while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0)
+		{
+			auto state = InterlockedCompareExchange(&channel->state, 0, 0);
+			if (state == POOL_WORKER_EXIT)
+			{
+				break;
+			}
+			if (state != POOL_WORKER_BUSY)
+			{
+				continue;
+			}
+			channel->status = handler(std::string(channel->request), channel->job, channel->slot, writer.get());
+			writer->Flush();
+			InterlockedExchange(&channel->state, POOL_WORKER_DONE);
+			SetEvent(notify);
+		}
+		ret = 0;
+	}
+	else
+	{
+		Log.e("Worker: cannot open %s", channelName);
+	}
+	if (parent)
+	{
+		CloseHandle(parent);
+	}
+	if (request)
+	{
+		CloseHandle(request);
+	}
+	if (notify)
+	{
+		CloseHandle(notify);
+	}
+	if (channel)
+	{
+		UnmapViewOfFile(channel);
+	}
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+	return ret;
+}
@@ -0,0 +1,105 @@
+/****************************************************************************
+; *
+; * 	File		:	oevPool.h
+; *
+; * 	Description :	Process isolated test runners
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <Windows.h>
+#include "oevResultWriter.h"
+
+struct PoolChannel;
+
+// One configuration of a pool run
+struct PoolJob
+{
+	std::string options; // FormatTestOptions
+	bool concurrent; // CPU only renderer (RENDERER_GDI), can run next to other concurrent jobs
+};
+
+/// <summary>
+/// Runs configurations in child processes of the same executable, started with --worker.
+/// Each worker loads infogl.dll and GLVIEW.RMX before its first job, receives jobs through
+/// shared memory and formats its results with a ResultWriter into a ring read by the pool.
+/// The results of a job are forwarded when it completes: a crash, or a job running longer than
+/// the timeout, only loses the job of that worker. The worker is restarted and the job retried,
+/// the results of the other jobs are not affected.
+/// Jobs start in order. Consecutive concurrent jobs fill the workers, a GPU job runs alone
+/// so that no other job competes with its CPU and GPU timings.
+/// </summary>
+class RunnerPool
+{
+public:
+	/// <summary>
+	/// </summary>
+	/// <param name="workerCount">Child processes, at most MAXIMUM_WAIT_OBJECTS / 2</param>
+	/// <param name="timeoutSeconds">Maximum duration of a job</param>
+	/// <param name="workerArguments">Appended to the worker command lines, e.g. --format json</param>
+	RunnerPool(int workerCount, int timeoutSeconds, const std::string& workerArguments);
+	~RunnerPool();
+	RunnerPool(const RunnerPool&) = delete;
+	RunnerPool& operator=(const RunnerPool&) = delete;
+
+	// Start the workers without waiting for them to load. false if none could be started
+	bool Start();
+
+	/// <summary>
+	/// Run jobs until each one completed or failed kMaxAttempts times
+	/// </summary>
+	/// <param name="jobs"></param>
+	/// <param name="writer">Receives the results, a "crashed" event per lost attempt and a "failed" event per abandoned job</param>
+	/// <returns>0, or the status of the last failing job</returns>
+	int Run(const std::vector<PoolJob>& jobs, ResultWriter* writer);
+
+	static const int kMaxAttempts = 3;
+
+private:
+	struct Worker
+	{
+		int slot = 0;
+		int generation = 0;
+		HANDLE process = nullptr;
+		HANDLE mapping = nullptr;
+		PoolChannel* channel = nullptr;
+		HANDLE request = nullptr; // Pool to worker
+		HANDLE notify = nullptr; // Worker to pool: ready, output available, job done
+		bool ready = false;
+		int startFailures = 0; // In a row, the slot is given up after kMaxAttempts
+		int job = -1; // Running job, -1 if idle
+		ULONGLONG jobStart = 0;
+		std::string staged; // Output of the running job
+	};
+	bool Spawn(Worker& worker);
+	void Close(Worker& worker, bool wait);
+
+	std::vector<Worker> workers;
+	int timeoutSeconds;
+	std::string workerArguments;
+};
+
+// Worker side: runs one job, jobId tags its results, slot is the same for every restart of a worker
+typedef std::function<int(const std::string& options, int jobId, int slot, ResultWriter* writer)> PoolJobHandler;
+
+/// <summary>
+/// Body of a --worker process, called once the session is loaded.
+/// Returns when the pool exits or goes away.
+/// </summary>
+/// <param name="channelName">--worker value</param>
+/// <param name="format">Same as the pool writer</param>
+/// <param name="handler"></param>
+/// <returns></returns>
+int RunPoolWorker(const char* channelName, ResultFormat format, const PoolJobHandler& handler);
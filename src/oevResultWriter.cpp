@@ -0,0 +1,588 @@
+/****************************************************************************
+; *
+; * 	File		:	oevResultWriter.cpp
+; *
+; * 	Description :	Streaming rendering test result writer
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#include "oevResultWriter.h"
+#include <chrono>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Buffered bytes before the writer thread is woken up
+static const size_t kFlushThreshold = 64 * 1024;
+// Maximum delay of buffered data
+static const int kFlushIntervalMs = 250;
+
+static inline const gvFrameTimings* get_frame_timings(const gvRenderingTestResult* result)
+{
+	return OEV_HAS_FIELD(result, gvRenderingTestResult, frameTimings) ? result->frameTimings : nullptr;
+}
+static inline int get_config_index(const gvRenderingTestResult* result)
+{
+	return OEV_HAS_FIELD(result, gvRenderingTestResult, configIndex) ? result->configIndex : 0;
+}
+static inline int get_adapter(const gvRenderingTestResult* result)
+{
+	return OEV_HAS_FIELD(result, gvRenderingTestResult, adapter) ? result->adapter : 0;
+}
+// -1 when the DLL does not report it
+static inline int get_fbformat(const gvRenderingTestResult* result)
+{
+	return OEV_HAS_FIELD(result, gvRenderingTestResult, fbformat) ? result->fbformat : -1;
+}
+static inline int get_multisample(const gvRenderingTestResult* result)
+{
+	return OEV_HAS_FIELD(result, gvRenderingTestResult, multisample) ? result->multisample : -1;
+}
+static inline const gvLatencyStats* get_latency(const gvRenderingTestResult* result)
+{
+	return OEV_HAS_FIELD(result, gvRenderingTestResult, latency) ? result->latency : nullptr;
+}
+static inline int get_pass_count(const gvRenderingTestResult* result)
+{
+	return OEV_HAS_FIELD(result, gvRenderingTestResult, passes) && result->passes ? result->passCount : 0;
+}
+static void append_format(std::string& out, const char* format, ...)
+{
+	char buffer[512];
+	va_list argptr;
+	va_start(argptr, format);
+	va_list retry;
+	va_copy(retry, argptr);
+	auto n = vsnprintf(buffer, sizeof(buffer), format, argptr);
+	va_end(argptr);
+	if (n >= (int)sizeof(buffer))
+	{
+		// Long tags or test names, format again in place
+		auto size = out.size();
+		out.resize(size + n + 1);
+		vsnprintf(&out[size], n + 1, format, retry);
+		out.resize(size + n);
+	}
+	else if (n > 0)
+	{
+		out.append(buffer, n);
+	}
+	va_end(retry);
+}
+void ResultWriter::AppendJsonString(std::string& out, const char* value)
+{
+	out += '"';
+	for (auto p = value ? value : ""; *p; p++)
+	{
+		auto c = *p;
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			append_format(out, "\\u%04x", (unsigned char)c);
+		}
+		else
+		{
+			out += c;
+		}
+	}
+	out += '"';
+}
+static inline float get_sample(const float* samples, int i)
+{
+	return samples ? samples[i] : 0.0f;
+}
+
+class JsonLinesResultWriter : public ResultWriter
+{
+public:
+	JsonLinesResultWriter(HANDLE handle, bool ownHandle, bool frames) : ResultWriter(handle, ownHandle, frames) {}
+protected:
+	void FormatResult(std::string& out, const gvRenderingTestResult* result, long long timeMs, const char* tag) override
+	{
+		append_format(out, "{\"type\":\"result\",\"time\":%lld,\"adapter\":%d,\"config\":%d,\"test\":%d,\"result\":",
+			timeMs, get_adapter(result), get_config_index(result), result->index);
+		AppendJsonString(out, result->result);
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, status))
+		{
+			append_format(out, ",\"status\":%d", result->status);
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, multisample))
+		{
+			append_format(out, ",\"fbformat\":%d,\"multisample\":%d", result->fbformat, result->multisample);
+		}
+		append_format(out, ",\"duration\":%d,\"fps\":%g", result->duration, result->fps);
+		auto timings = get_frame_timings(result);
+		if (timings)
+		{
+			append_format(out, ",\"frames\":%d,\"min\":%g,\"max\":%g,\"p50\":%g,\"p95\":%g,\"p99\":%g,\"low1\":%g",
+				timings->frameCount, timings->minTime, timings->maxTime, timings->p50, timings->p95, timings->p99, timings->low1);
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, throttled))
+		{
+			append_format(out, ",\"throttled\":%s", result->throttled ? "true" : "false");
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, achievedRse))
+		{
+			append_format(out, ",\"samples\":%d,\"measured\":%d,\"rse\":%g", result->sampleCount, result->measuredTime, result->achievedRse);
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, warmupSteady))
+		{
+			append_format(out, ",\"warmup\":%d,\"warmupSteady\":%s", result->warmupTime, result->warmupSteady ? "true" : "false");
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, cacheMisses))
+		{
+			append_format(out, ",\"cacheHits\":%d,\"cacheMisses\":%d", result->cacheHits, result->cacheMisses);
+		}
+		auto passCount = get_pass_count(result);
+		if (passCount > 0)
+		{
+			out += ",\"passes\":[";
+			for (int i = 0; i < passCount; i++)
+			{
+				out += i ? ",{\"name\":" : "{\"name\":";
+				AppendJsonString(out, result->passes[i].name);
+				append_format(out, ",\"gpu\":%g,\"gpuMax\":%g}", result->passes[i].gpuTime, result->passes[i].gpuTimeMax);
+			}
+			out += ']';
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, threads) && result->threads && result->threadCount > 0)
+		{
+			append_format(out, ",\"submitCpu\":%g,\"threads\":[", result->submitCpuTime);
+			for (int i = 0; i < result->threadCount; i++)
+			{
+				auto& thread = result->threads[i];
+				append_format(out, "%s{\"cpu\":%g,\"busy\":%g,\"items\":%d,\"steals\":%d}", i ? "," : "",
+					thread.cpuTime, thread.busy, thread.items, thread.steals);
+			}
+			out += ']';
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, drawModes) && result->drawModes && result->drawModeCount > 0)
+		{
+			out += ",\"drawModes\":[";
+			for (int i = 0; i < result->drawModeCount; i++)
+			{
+				auto& mode = result->drawModes[i];
+				append_format(out, "%s{\"mode\":%d,\"drawsPerSecond\":%g,\"cpu\":%g,\"gpu\":%g,\"fps\":%g}", i ? "," : "",
+					mode.mode, mode.drawsPerSecond, mode.cpuTime, mode.gpuTime, mode.fps);
+			}
+			out += ']';
+		}
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, streaming) && result->streaming)
+		{
+			auto streaming = result->streaming;
+			append_format(out, ",\"streaming\":{\"bytes\":%llu,\"gbps\":%g,\"latency\":%g,\"latencyP99\":%g,\"latencyMax\":%g,"
+				"\"jitter\":%g,\"idleJitter\":%g,\"stalls\":%d,\"transferQueue\":%s}",
+				streaming->bytesUploaded, streaming->throughput, streaming->latencyMean, streaming->latencyP99, streaming->latencyMax,
+				streaming->frameTimeJitter, streaming->idleFrameTimeJitter, streaming->stalls, streaming->transferQueue ? "true" : "false");
+		}
+		auto latency = get_latency(result);
+		if (latency)
+		{
+			append_format(out, ",\"latency\":{\"source\":%d,\"presents\":%d,\"refresh\":%g,\"mean\":%g,\"p50\":%g,\"p95\":%g,\"p99\":%g,\"max\":%g,\"jitter\":%g,\"missedVblanks\":%d}",
+				latency->source, latency->presentCount, latency->refreshInterval, latency->mean, latency->p50, latency->p95, latency->p99,
+				latency->max, latency->displayIntervalJitter, latency->missedVblanks);
+		}
+		if (job >= 0)
+		{
+			append_format(out, ",\"job\":%d", job);
+		}
+		if (tag && *tag)
+		{
+			out += ',';
+			out += tag;
+		}
+		out += "}\n";
+	}
+	void FormatFrames(std::string& out, const gvRenderingTestResult* result, const gvFrameTimings* timings) override
+	{
+		if (OEV_HAS_FIELD(result, gvRenderingTestResult, telemetry) && result->telemetry)
+		{
+			for (int i = 0; i < result->telemetryCount; i++)
+			{
+				auto& sample = result->telemetry[i];
+				append_format(out, "{\"type\":\"telemetry\",\"adapter\":%d,\"config\":%d,\"test\":%d,\"time\":%g,"
+					"\"cpuClock\":%g,\"gpuCoreClock\":%g,\"gpuMemoryClock\":%g,\"cpuTemperature\":%g,\"gpuTemperature\":%g,\"cpuPower\":%g,\"gpuPower\":%g}\n",
+					get_adapter(result), get_config_index(result), result->index, sample.time,
+					sample.cpuClock, sample.gpuCoreClock, sample.gpuMemoryClock, sample.cpuTemperature, sample.gpuTemperature, sample.cpuPower, sample.gpuPower);
+			}
+		}
+		auto latency = get_latency(result);
+		for (int i = 0; latency && latency->latency && i < latency->presentCount; i++)
+		{
+			append_format(out, "{\"type\":\"present\",\"adapter\":%d,\"config\":%d,\"test\":%d,\"present\":%d,\"latency\":%g}\n",
+				get_adapter(result), get_config_index(result), result->index, i, latency->latency[i]);
+		}
+		for (int i = 0; timings && i < timings->frameCount; i++)
+		{
+			append_format(out, "{\"type\":\"frame\",\"adapter\":%d,\"config\":%d,\"test\":%d,\"frame\":%d,\"time\":%g,\"cpu\":%g,\"gpu\":%g}\n",
+				get_adapter(result), get_config_index(result), result->index, i,
+				get_sample(timings->frameTime, i), get_sample(timings->cpuTime, i), get_sample(timings->gpuTime, i));
+		}
+	}
+	void FormatEvent(std::string& out, const char* name, int id, int status, long long timeMs) override
+	{
+		append_format(out, "{\"type\":\"event\",\"time\":%lld,\"event\":", timeMs);
+		AppendJsonString(out, name);
+		append_format(out, ",\"id\":%d,\"status\":%d}\n", id, status);
+	}
+};
+
+class CsvResultWriter : public ResultWriter
+{
+public:
+	CsvResultWriter(HANDLE handle, bool ownHandle, bool frames) : ResultWriter(handle, ownHandle, frames) {}
+protected:
+	void FormatHeader(std::string& out) override
+	{
+		out += "kind,time,adapter,config,test,result,duration,fps,frames,min,max,p50,p95,p99,low1,frame,frame_ms,cpu_ms,gpu_ms,fbformat,multisample,job\n";
+	}
+	void FormatResult(std::string& out, const gvRenderingTestResult* result, long long timeMs, const char* tag) override
+	{
+		(void)tag;
+		append_format(out, "result,%lld,%d,%d,%d,%s,%d,%g", timeMs, get_adapter(result), get_config_index(result), result->index,
+			result->result && !strpbrk(result->result, ",\"\n") ? result->result : "", result->duration, result->fps);
+		auto timings = get_frame_timings(result);
+		if (timings)
+		{
+			append_format(out, ",%d,%g,%g,%g,%g,%g,%g,,,,",
+				timings->frameCount, timings->minTime, timings->maxTime, timings->p50, timings->p95, timings->p99, timings->low1);
+		}
+		else
+		{
+			out += ",,,,,,,,,,,";
+		}
+		if (get_multisample(result) >= 0)
+		{
+			append_format(out, ",%d,%d", get_fbformat(result), get_multisample(result));
+		}
+		else
+		{
+			out += ",,";
+		}
+		AppendJob(out);
+	}
+	void FormatFrames(std::string& out, const gvRenderingTestResult* result, const gvFrameTimings* timings) override
+	{
+		for (int i = 0; timings && i < timings->frameCount; i++)
+		{
+			append_format(out, "frame,,%d,%d,%d,,,,,,,,,,,%d,%g,%g,%g,,", get_adapter(result), get_config_index(result), result->index, i,
+				get_sample(timings->frameTime, i), get_sample(timings->cpuTime, i), get_sample(timings->gpuTime, i));
+			AppendJob(out);
+		}
+	}
+	// Last column, empty outside of a pool worker
+	void AppendJob(std::string& out)
+	{
+		if (job >= 0)
+		{
+			append_format(out, ",%d\n", job);
+		}
+		else
+		{
+			out += ",\n";
+		}
+	}
+	// Event rows: config is the id, result the name and duration the status
+	void FormatEvent(std::string& out, const char* name, int id, int status, long long timeMs) override
+	{
+		append_format(out, "event,%lld,,%d,,%s,%d,,,,,,,,,,,,,,,\n", timeMs, id, name && !strpbrk(name, ",\"\n") ? name : "", status);
+	}
+};
+
+class BinaryResultWriter : public ResultWriter
+{
+public:
+	BinaryResultWriter(HANDLE handle, bool ownHandle, bool frames) : ResultWriter(handle, ownHandle, frames) {}
+protected:
+#pragma pack(push, 1)
+	struct ResultRecord
+	{
+		int64_t timeMs;
+		int32_t config;
+		int32_t test;
+		int32_t passed;
+		int32_t duration;
+		float fps;
+		int32_t frames;
+		float minTime, maxTime, p50, p95, p99, low1;
+		int32_t adapter;
+		int32_t fbformat; // -1 if unknown
+		int32_t multisample;
+		int32_t job; // Pool job id, -1 if none
+	};
+	struct FramesRecord
+	{
+		int32_t adapter;
+		int32_t config;
+		int32_t test;
+		int32_t frames;
+		int32_t job;
+		// Followed by frames * { frameTime, cpuTime, gpuTime }
+	};
+	struct EventRecord
+	{
+		int64_t timeMs;
+		int32_t id;
+		int32_t status;
+		char name[16];
+	};
+#pragma pack(pop)
+	static void AppendRecord(std::string& out, uint32_t type, const void* data, uint32_t size)
+	{
+		out.append((const char*)&type, sizeof(type));
+		out.append((const char*)&size, sizeof(size));
+		out.append((const char*)data, size);
+	}
+	void FormatHeader(std::string& out) override
+	{
+		// 2: ResultRecord fbformat and multisample
+		// 3: ResultRecord and FramesRecord job
+		uint32_t version = 3;
+		out.append("GVRB", 4);
+		out.append((const char*)&version, sizeof(version));
+	}
+	void FormatResult(std::string& out, const gvRenderingTestResult* result, long long timeMs, const char* tag) override
+	{
+		(void)tag;
+		ResultRecord record = {};
+		record.timeMs = timeMs;
+		record.config = get_config_index(result);
+		record.test = result->index;
+		record.passed = oevIsTestPassed(result);
+		record.duration = result->duration;
+		record.fps = result->fps;
+		record.adapter = get_adapter(result);
+		record.fbformat = get_fbformat(result);
+		record.multisample = get_multisample(result);
+		record.job = job;
+		auto timings = get_frame_timings(result);
+		if (timings)
+		{
+			record.frames = timings->frameCount;
+			record.minTime = timings->minTime;
+			record.maxTime = timings->maxTime;
+			record.p50 = timings->p50;
+			record.p95 = timings->p95;
+			record.p99 = timings->p99;
+			record.low1 = timings->low1;
+		}
+		AppendRecord(out, RESULTWRITER_RECORD_RESULT, &record, sizeof(record));
+	}
+	void FormatFrames(std::string& out, const gvRenderingTestResult* result, const gvFrameTimings* timings) override
+	{
+		if (!timings)
+		{
+			return;
+		}
+		uint32_t type = RESULTWRITER_RECORD_FRAMES;
+		uint32_t size = (uint32_t)(sizeof(FramesRecord) + (size_t)timings->frameCount * 3 * sizeof(float));
+		FramesRecord record = { get_adapter(result), get_config_index(result), result->index, timings->frameCount, job };
+		out.reserve(out.size() + 8 + size);
+		out.append((const char*)&type, sizeof(type));
+		out.append((const char*)&size, sizeof(size));
+		out.append((const char*)&record, sizeof(record));
+		for (int i = 0; i < timings->frameCount; i++)
+		{
+			float sample[3] = { get_sample(timings->frameTime, i), get_sample(timings->cpuTime, i), get_sample(timings->gpuTime, i) };
+			out.append((const char*)sample, sizeof(sample));
+		}
+	}
+	void FormatEvent(std::string& out, const char* name, int id, int status, long long timeMs) override
+	{
+		EventRecord record = {};
+		record.timeMs = timeMs;
+		record.id = id;
+		record.status = status;
+		auto length = name ? strlen(name) : 0;
+		memcpy(record.name, name ? name : "", length < sizeof(record.name) ? length : sizeof(record.name) - 1);
+		AppendRecord(out, RESULTWRITER_RECORD_EVENT, &record, sizeof(record));
+	}
+};
+
+std::unique_ptr<ResultWriter> ResultWriter::Open(const char* path, ResultFormat format, bool frames)
+{
+	HANDLE handle = INVALID_HANDLE_VALUE;
+	bool ownHandle = true;
+	if (!strcmp(path, "-"))
+	{
+		handle = GetStdHandle(STD_OUTPUT_HANDLE);
+		ownHandle = false;
+	}
+	else
+	{
+		// Named pipes must already exist, files are truncated
+		auto pipe = !strncmp(path, "\\\\.\\pipe\\", 9);
+		handle = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+			pipe ? OPEN_EXISTING : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	}
+	if (handle == INVALID_HANDLE_VALUE || handle == nullptr)
+	{
+		return nullptr;
+	}
+	auto writer = Create(handle, ownHandle, format, frames);
+	writer->Start();
+	return writer;
+}
+std::unique_ptr<ResultWriter> ResultWriter::Open(ResultSink sink, ResultFormat format, bool frames, bool header)
+{
+	auto writer = Create(INVALID_HANDLE_VALUE, false, format, frames);
+	writer->sink = std::move(sink);
+	writer->Start(header);
+	return writer;
+}
+std::unique_ptr<ResultWriter> ResultWriter::Create(HANDLE handle, bool ownHandle, ResultFormat format, bool frames)
+{
+	std::unique_ptr<ResultWriter> writer;
+	switch (format)
+	{
+	case ResultFormat::Csv:
+		writer.reset(new CsvResultWriter(handle, ownHandle, frames));
+		break;
+	case ResultFormat::Binary:
+		writer.reset(new BinaryResultWriter(handle, ownHandle, frames));
+		break;
+	default:
+		writer.reset(new JsonLinesResultWriter(handle, ownHandle, frames));
+		break;
+	}
+	return writer;
+}
+ResultWriter::ResultWriter(HANDLE handle, bool ownHandle, bool frames) :
+	frames(frames),
+	handle(handle),
+	ownHandle(ownHandle)
+{
+}
+ResultWriter::~ResultWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+	if (ownHandle)
+	{
+		CloseHandle(handle);
+	}
+}
+void ResultWriter::Start(bool header)
+{
+	if (header)
+	{
+		std::string out;
+		FormatHeader(out);
+		Append(out);
+	}
+	thread = std::thread(&ResultWriter::Run, this);
+}
+void ResultWriter::Append(const std::string& data)
+{
+	if (data.empty())
+	{
+		return;
+	}
+	bool notify;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending += data;
+		appended += data.size();
+		notify = pending.size() >= kFlushThreshold;
+	}
+	if (notify)
+	{
+		wake.notify_one();
+	}
+}
+void ResultWriter::Write(const gvRenderingTestResult* result, const char* tag)
+{
+	auto timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	// Format outside of the lock
+	std::string data;
+	FormatResult(data, result, (long long)timeMs, tag);
+	auto timings = get_frame_timings(result);
+	auto telemetry = OEV_HAS_FIELD(result, gvRenderingTestResult, telemetry) && result->telemetry && result->telemetryCount > 0;
+	auto latency = get_latency(result);
+	auto presents = latency && latency->latency && latency->presentCount > 0;
+	if (frames && ((timings && timings->frameCount > 0) || telemetry || presents))
+	{
+		// timings can be NULL
+		FormatFrames(data, result, timings);
+	}
+	Append(data);
+}
+void ResultWriter::WriteEvent(const char* name, int id, int status)
+{
+	auto timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	std::string data;
+	FormatEvent(data, name, id, status, (long long)timeMs);
+	Append(data);
+}
+void ResultWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	auto target = appended;
+	wake.notify_one();
+	flushed.wait(lock, [&] { return written >= target; });
+}
+void ResultWriter::Run()
+{
+	std::string buffer;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		wake.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs), [&] { return stopping || !pending.empty(); });
+		if (pending.empty())
+		{
+			if (stopping)
+			{
+				break;
+			}
+			continue;
+		}
+		buffer.swap(pending);
+		lock.unlock();
+		// Reader went away: drop the data but keep Flush() from blocking
+		Output(buffer.data(), buffer.size());
+		auto size = buffer.size();
+		buffer.clear();
+		lock.lock();
+		written += size;
+		flushed.notify_all();
+	}
+}
+bool ResultWriter::Output(const char* data, size_t size)
+{
+	if (sink)
+	{
+		return sink(data, size);
+	}
+	size_t offset = 0;
+	while (offset < size)
+	{
+		DWORD n = 0;
+		if (!WriteFile(handle, data + offset, (DWORD)(size - offset), &n, nullptr) || n == 0)
+		{
+			return false;
+		}
+		offset += n;
+	}
+	return true;
+}
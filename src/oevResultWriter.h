@@ -0,0 +1,104 @@
+/****************************************************************************
+; *
+; * 	File		:	oevResultWriter.h
+; *
+; * 	Description :	Streaming rendering test result writer
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <Windows.h>
+#include "include/oevSDK.h"
+
+enum class ResultFormat
+{
+	JsonLines,
+	Csv,
+	Binary // "GVRB" + version, then records { uint32 type, uint32 size, payload }
+};
+
+// Binary record types
+#define RESULTWRITER_RECORD_RESULT 1
+#define RESULTWRITER_RECORD_FRAMES 2
+#define RESULTWRITER_RECORD_EVENT 3
+
+// Custom output, e.g. a socket. Returns false when the data could not be sent
+typedef std::function<bool(const char* data, size_t size)> ResultSink;
+
+/// <summary>
+/// Streams gvRenderingTestResult to a file, a named pipe or stdout.
+/// Write() only formats into a memory buffer, a background thread does the I/O.
+/// </summary>
+class ResultWriter
+{
+public:
+	/// <summary>
+	/// Open a writer
+	/// </summary>
+	/// <param name="path">File path, \\.\pipe\name or "-" for stdout</param>
+	/// <param name="format"></param>
+	/// <param name="frames">Also write per-frame samples</param>
+	/// <returns>nullptr on failure</returns>
+	static std::unique_ptr<ResultWriter> Open(const char* path, ResultFormat format, bool frames = true);
+	// Same, the sink is called from the writer thread.
+	// header false leaves out the CSV header / binary signature, for output spliced into another writer
+	static std::unique_ptr<ResultWriter> Open(ResultSink sink, ResultFormat format, bool frames = true, bool header = true);
+	static void AppendJsonString(std::string& out, const char* value);
+	virtual ~ResultWriter();
+	ResultWriter(const ResultWriter&) = delete;
+	ResultWriter& operator=(const ResultWriter&) = delete;
+
+	// Thread safe, can be called from the SDK callback.
+	// tag: extra JSON members of the result object, e.g. the machine identity, JSON lines only
+	void Write(const gvRenderingTestResult* result, const char* tag = nullptr);
+	// Out of band marker, e.g. the end of a batch in --serve mode
+	void WriteEvent(const char* name, int id, int status);
+	// Pool job id written with the next results, -1 for none. Set between jobs, in a worker process
+	void SetJob(int id) { job = id; }
+	// Records formatted by a writer of the same format without header, e.g. in a worker process
+	void WriteRaw(const char* data, size_t size) { Append(std::string(data, size)); }
+	// Write everything buffered so far, blocks until written
+	void Flush();
+
+protected:
+	ResultWriter(HANDLE handle, bool ownHandle, bool frames);
+	void Start(bool header = true);
+	void Append(const std::string& data);
+	virtual void FormatHeader(std::string& out) { (void)out; }
+	virtual void FormatResult(std::string& out, const gvRenderingTestResult* result, long long timeMs, const char* tag) = 0;
+	virtual void FormatFrames(std::string& out, const gvRenderingTestResult* result, const gvFrameTimings* timings) = 0;
+	virtual void FormatEvent(std::string& out, const char* name, int id, int status, long long timeMs) = 0;
+	bool frames;
+	int job = -1;
+
+private:
+	static std::unique_ptr<ResultWriter> Create(HANDLE handle, bool ownHandle, ResultFormat format, bool frames);
+	void Run();
+	bool Output(const char* data, size_t size);
+	HANDLE handle;
+	bool ownHandle;
+	ResultSink sink;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable flushed;
+	std::string pending;
+	unsigned long long appended = 0;
+	unsigned long long written = 0;
+	bool stopping = false;
+	std::thread thread;
+};
@@ -17,6 +17,11 @@
 ; ***************************************************************************/
 // OpenGL Extensions Viewer headers.
 #include <string>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <map>
+#include <functional>
 #include <Windows.h>
 #include <ShellScalingAPI.h>
 #include <VersionHelpers.h>
@@ -31,149 +36,275 @@
 	"publicKeyToken='6595b64144ccf1df' "\
 	"language='*'\"")
 #include "include/oevSDK.h"
+#include "oevResultWriter.h"
+#include "oevConfig.h"
+#include "oevAgent.h"
+#include "oevTrace.h"
+#include "oevPool.h"
+#include "oevLog.h"
 using namespace std;
-class DebugLog
-{
-public:
-	char szTextBuffer[4096];
-	void v(const char* format, ...)
-	{
-		va_list argptr;
-		va_start(argptr, format);
-		vsnprintf(szTextBuffer, sizeof(szTextBuffer), format, argptr);
-		va_end(argptr);
-		OutputDebugStringA("[INFO] ");
-		OutputDebugStringA(szTextBuffer);
-		OutputDebugStringA("\n");
-	}
-	void e(const char* format, ...)
-	{
-		va_list argptr;
-		va_start(argptr, format);
-		vsnprintf(szTextBuffer, sizeof(szTextBuffer), format, argptr);
-		va_end(argptr);
-		OutputDebugStringA("[ERROR] ");
-		OutputDebugStringA(szTextBuffer);
-		OutputDebugStringA("\n");
-	}
-};
 static DebugLog Log;
 /// <summary>
 /// 
 /// </summary>
 /// <param name="width"></param>
 /// <param name="height"></param>
-/// <returns></returns>
+/// <returns>Display mode of the primary monitor, OEV_DISPLAYMODE_NOT_FOUND if not supported</returns>
 static int GetDisplayMode(int width, int height)
 {
-	int n = 0;
-	DEVMODE  devmode = { 0 };
-	devmode.dmSize = sizeof(DEVMODE);
-	for (;;)
+	// Enumerated once for the whole sweep
+	static const oevDisplayModes displayModes;
+	return displayModes.Find(width, height);
+}
+/// <summary>
+/// 
+/// </summary>
+/// <param name="lpResult"></param>
+/// <returns>true if the test passed</returns>
+static bool log_rendering_test_result(const gvRenderingTestResult* lpResult)
+{
+	auto config = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, configIndex) ? lpResult->configIndex : 0;
+	auto adapter = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, adapter) ? lpResult->adapter : 0;
+	if (oevIsTestPassed(lpResult))
 	{
-		while (EnumDisplaySettings(nullptr, n, &devmode))
+		Log.v("Test '%d' config %d adapter %d passed, avg: %g fps.", lpResult->index, config, adapter, lpResult->fps);
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, multisample))
+		{
+			static const char* const fbformats[] = { "Linear", "sRGB", "HDR" };
+			Log.v("Test '%d' rendered to %s, %dx MSAA", lpResult->index,
+				lpResult->fbformat >= WGLDIAG_FB_LINEAR && lpResult->fbformat <= WGLDIAG_FB_HDR ? fbformats[lpResult->fbformat] : "?", lpResult->multisample);
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, frameTimings) && lpResult->frameTimings)
+		{
+			auto timings = lpResult->frameTimings;
+			Log.v("Test '%d' %d frames, min: %g ms, max: %g ms, p50: %g ms, p95: %g ms, p99: %g ms, 1%% low: %g fps.",
+				lpResult->index, timings->frameCount, timings->minTime, timings->maxTime,
+				timings->p50, timings->p95, timings->p99, timings->low1);
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, throttled) && lpResult->throttled)
+		{
+			Log.e("Test '%d' throttled, fps not representative", lpResult->index);
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, achievedRse))
+		{
+			Log.v("Test '%d' %d samples in %d ms, rse: %g", lpResult->index, lpResult->sampleCount, lpResult->measuredTime, lpResult->achievedRse);
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, warmupSteady))
+		{
+			Log.v("Test '%d' warm-up: %d ms%s", lpResult->index, lpResult->warmupTime, lpResult->warmupSteady ? "" : ", frame times did not settle");
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, cacheMisses))
+		{
+			Log.v("Test '%d' pipeline cache: %d hit(s), %d miss(es)", lpResult->index, lpResult->cacheHits, lpResult->cacheMisses);
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, latency) && lpResult->latency)
+		{
+			auto latency = lpResult->latency;
+			if (latency->source == LATENCY_NONE)
+			{
+				Log.e("Test '%d' latency not supported by this renderer or presentation mode", lpResult->index);
+			}
+			else
+			{
+				Log.v("Test '%d' latency (source %d): mean: %g ms, p50: %g ms, p99: %g ms, max: %g ms, jitter: %g ms, %d missed vblank(s) in %d presents",
+					lpResult->index, latency->source, latency->mean, latency->p50, latency->p99, latency->max,
+					latency->displayIntervalJitter, latency->missedVblanks, latency->presentCount);
+			}
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, threads) && lpResult->threads)
+		{
+			Log.v("Test '%d' %d worker thread(s), context thread: %g ms", lpResult->index, lpResult->threadCount, lpResult->submitCpuTime);
+			for (int i = 0; i < lpResult->threadCount; i++)
+			{
+				auto& thread = lpResult->threads[i];
+				Log.v("Test '%d' thread %d: %g ms, %g%% busy, %d item(s), %d steal(s)", lpResult->index, i,
+					thread.cpuTime, thread.busy * 100, thread.items, thread.steals);
+			}
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, drawModes) && lpResult->drawModes)
+		{
+			for (int i = 0; i < lpResult->drawModeCount; i++)
+			{
+				auto& mode = lpResult->drawModes[i];
+				if (mode.mode == 0)
+				{
+					Log.e("Test '%d' draw mode %d not supported", lpResult->index, i);
+					continue;
+				}
+				Log.v("Test '%d' draw mode 0x%x: %g draws/s, cpu: %g ms, gpu: %g ms, %g fps", lpResult->index,
+					mode.mode, mode.drawsPerSecond, mode.cpuTime, mode.gpuTime, mode.fps);
+			}
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, streaming) && lpResult->streaming)
+		{
+			auto streaming = lpResult->streaming;
+			Log.v("Test '%d' streaming: %g GB/s%s, upload to use: %g ms, p99: %g ms, jitter: %g ms (%g ms idle), %d stall(s)",
+				lpResult->index, streaming->throughput, streaming->transferQueue ? " on a transfer queue" : "",
+				streaming->latencyMean, streaming->latencyP99, streaming->frameTimeJitter, streaming->idleFrameTimeJitter, streaming->stalls);
+		}
+		if (OEV_HAS_FIELD(lpResult, gvRenderingTestResult, passes) && lpResult->passes)
 		{
-			if (width == devmode.dmPelsWidth && height == devmode.dmPelsHeight)
+			for (int i = 0; i < lpResult->passCount; i++)
 			{
-				return n;
+				Log.v("Test '%d' pass '%s': %g ms, max: %g ms", lpResult->index,
+					lpResult->passes[i].name, lpResult->passes[i].gpuTime, lpResult->passes[i].gpuTimeMax);
 			}
-			n++;
 		}
+		return true;
 	}
-	return -1;
+	Log.e("Test '%d' config %d adapter %d failed", lpResult->index, config, adapter);
+	return false;
 }
 /// <summary>
 /// 
 /// </summary>
-/// <param name="name"></param>
-/// <param name="value"></param>
-/// <returns></returns>
-static inline std::string CreateElement(const std::string& name, const std::string& value)
+/// <param name="session"></param>
+static void log_wad_stats(const oevSession& session)
 {
-	return "<" + name + ">" + value + "</" + name + ">\n";
+	gvWadStats stats;
+	if (session.GetWadStats(stats))
+	{
+		Log.v("Package: %d/%d entries decoded, %llu/%llu bytes paged in",
+			stats.entriesDecoded, stats.entryCount, stats.bytesPagedIn, stats.fileBytes);
+	}
+}
+/// <summary>
+/// Machine fingerprint: every available renderer with its driver
+/// </summary>
+/// <param name="session"></param>
+static void log_renderers(const oevSession& session)
+{
+	const gvCapabilities* caps[MAX_RENDERER];
+	auto count = session.ScanAllRenderers(caps);
+	Log.v("%d renderer(s) available", count);
+	for (int i = 0; i < MAX_RENDERER; i++)
+	{
+		if (caps[i])
+		{
+			Log.v("Renderer %d: %s, %s, %s", i,
+				session.funcCapsGetRendererName ? session.funcCapsGetRendererName(caps[i]) : "",
+				session.funcCapsGetVendorName ? session.funcCapsGetVendorName(caps[i]) : "",
+				session.funcCapsGetVersion ? session.funcCapsGetVersion(caps[i]) : "");
+			session.funcCapsRelease(caps[i]);
+		}
+	}
+}
+struct RenderingTestProgress
+{
+	std::atomic<int> completed{ 0 };
+	std::atomic<int> failed{ 0 };
+	ResultWriter* writer = nullptr;
+	const std::vector<std::string>* tags = nullptr; // Per configuration, extra JSON members of the results
+};
+// Extra JSON members of the results of a configuration, config.adapter is the adapter it runs on
+typedef std::function<std::string(const gvRenderingTestConfig& config)> TagBuilder;
+/// <summary>
+/// Called from the SDK worker thread as each test finishes
+/// </summary>
+/// <param name="lpResult"></param>
+/// <param name="userData"></param>
+static void on_rendering_test_result(const gvRenderingTestResult* lpResult, void* userData)
+{
+	OEV_TRACE_SCOPE("result", "harness", lpResult->index);
+	auto progress = (RenderingTestProgress*)userData;
+	if (progress->writer)
+	{
+		auto config = OEV_HAS_FIELD(lpResult, gvRenderingTestResult, configIndex) ? lpResult->configIndex : 0;
+		auto tag = progress->tags && config >= 0 && config < (int)progress->tags->size() ? (*progress->tags)[config].c_str() : nullptr;
+		progress->writer->Write(lpResult, tag);
+	}
+	if (!log_rendering_test_result(lpResult))
+	{
+		progress->failed++;
+	}
+	progress->completed++;
 }
 /// <summary>
 /// 
 /// </summary>
-/// <param name="renderer"></param>
-/// <param name="fullscreen"></param>
-/// <param name="width"></param>
-/// <param name="height"></param>
-/// <param name="vsync"></param>
-/// <param name="fog"></param>
-/// <param name="transparency"></param>
-/// <param name="user_clip_pane"></param>
-/// <param name="multisampling"></param>
-/// <param name="maxAnisotropy"></param>
-/// <param name="texture_load"></param>
-/// <param name="pixel_format"></param>
-/// <param name="scene"></param>
-/// <param name="fbformat"></param>
-/// <param name="test_duration"></param>
-/// <returns></returns>
-static int run_rendering_test(ovRenderer renderer,
-	int debug,
-	int fullscreen,
-	int width,
-	int height,
-	int vsync,
-	int fog,
-	int transparency,
-	int user_clip_pane,
-	const string& multisampling,
-	const string& maxAnisotropy,
-	const string& texture_load,
-	const string& pixel_format,
-	const string& scene,
-	const string& fbformat,
-	int test_duration)
+/// <param name="options">Settings of the configuration, see oevConfig.h</param>
+/// <returns>tests is not set, the caller picks them</returns>
+static gvRenderingTestConfig create_rendering_test_config(const TestOptions& options)
 {
-	std::string szXml;
+	gvRenderingTestConfig config = {};
+	config.structSize = sizeof(config);
 	int option = 0;
-	if (fullscreen) {
+	if (options.fullscreen) {
 		option |= (WGLDIAG_OPTION_FS | WGLDIAG_OPTIONS_FS_EX);
 	}
-	if (debug) {
+	if (options.debug) {
 		option |= (WGLDIAG_OPTION_DEBUG);
 	}
-	if (vsync) {
+	if (options.vsync) {
 		option |= (WGLDIAG_OPTION_VSYNC);
 	}
-	if (fog) {
+	if (options.fog) {
 		option |= (WGLDIAG_OPTION_FOG);
 	}
-	if (transparency) {
+	if (options.transparency) {
 		option |= (WGLDIAG_OPTION_TRANSPARENCY);
 	}
-	if (user_clip_pane) {
+	if (options.clipPlane) {
 		option |= (WGLDIAG_OPTION_CLIP_PLANE);
 	}
-	szXml = szXml + CreateElement("option", std::to_string(option));
-	szXml = szXml + CreateElement("fbformat", fbformat);
-	szXml = szXml + CreateElement("duration", std::to_string(test_duration));
-	szXml = szXml + CreateElement("multisample", multisampling);
-	szXml = szXml + CreateElement("anisotropy", maxAnisotropy);
-	szXml = szXml + CreateElement("texturelod", texture_load);
-	szXml = szXml + CreateElement("displaymode", std::to_string(GetDisplayMode(width, height)));
-	szXml = szXml + CreateElement("renderer", std::to_string(renderer));
-	szXml = szXml + CreateElement("pixelformat", pixel_format);
-	if (renderer == RENDERER_GDI || renderer == RENDERER_GL2_0)
-	{
-		szXml = szXml + CreateElement("test", "1.1;1.2;1.3;1.5;2.0");
+	if (options.profile) {
+		option |= (WGLDIAG_OPTION_PROFILE);
 	}
-	else if (renderer >= RENDERER_GL3_0 && renderer <= RENDERER_GL4_6)
-	{
-		szXml = szXml + CreateElement("test", "3.0;3.1;3.2;3.3;4.0;4.1;4.2;4.3;4.4;4.5");
+	if (options.latency) {
+		option |= (WGLDIAG_OPTION_LATENCY);
 	}
-	else if (renderer >= RENDERER_VK1_0)
-	{
-		szXml = szXml + CreateElement("test", "1.0");
+	if (options.threads) {
+		option |= (WGLDIAG_OPTION_MPENGINE);
+	}
+	if (options.headless) {
+		option &= ~(WGLDIAG_OPTION_FS | WGLDIAG_OPTIONS_FS_EX);
+		option |= (WGLDIAG_OPTION_HEADLESS);
 	}
-	szXml = szXml + CreateElement("fbenable", "Default");
-	szXml = szXml + CreateElement("fbformat", fbformat);
-	szXml = szXml + CreateElement("scene", scene);
-	szXml = szXml + CreateElement("width", std::to_string(width));
-	szXml = szXml + CreateElement("height", std::to_string(height));
+	config.renderer = options.renderer;
+	config.option = option;
+	config.fbformat = options.fbformat;
+	config.duration = options.duration;
+	config.multisample = options.multisampling;
+	config.anisotropy = options.anisotropy;
+	config.textureLod = options.textureLod;
+	config.displayMode = options.headless ? 0 : GetDisplayMode(options.width, options.height);
+	config.pixelFormat = options.pixelFormat;
+	config.scene = options.scene;
+	config.width = options.width;
+	config.height = options.height;
+	// Warm starts skip shader and pipeline compilation
+	config.pipelineCache = options.cache.empty() ? nullptr : options.cache.c_str();
+	// Skip shader compilation, uploads and clock ramp-up until frame times settle
+	config.warmup = options.warmup;
+	config.warmupTolerance = options.warmupTolerance;
+	config.warmupWindow = options.warmupWindow;
+	// duration becomes an upper bound
+	config.targetRse = options.targetRse;
+	config.minDuration = options.minDuration;
+	// Clocks, temperatures and power, to flag throttled runs
+	config.telemetryInterval = options.telemetry;
+	config.workerThreads = options.threads;
+	config.objectCount = options.objects;
+	config.drawModes = options.drawModes;
+	config.streamBudget = options.streamBudget;
+	config.streamQueueDepth = options.streamQueueDepth;
+	config.fbformatMask = options.fbformatMask;
+	config.multisampleMask = options.multisampleMask;
+	return config;
+}
+/// <summary>
+/// 
+/// </summary>
+/// <param name="session">Loaded once by WinMain</param>
+/// <param name="configs">Configurations created by create_rendering_test_config, run as one batch</param>
+/// <param name="writer">Optional, receives the results as they finish</param>
+/// <param name="stop_on_failure">Cancel the remaining tests after the first failure</param>
+/// <param name="tags">Optional, per configuration, see ResultWriter::Write</param>
+/// <returns></returns>
+static int run_rendering_tests(oevSession& session, const std::vector<gvRenderingTestConfig>& configs, ResultWriter* writer = nullptr, bool stop_on_failure = false,
+	const std::vector<std::string>* tags = nullptr)
+{
+	OEV_TRACE_SCOPE("run_rendering_tests", "harness", (int)configs.size());
 	// Enable 
 	if (IsWindows8OrGreater()) {
 		auto monitor = MonitorFromWindow(GetActiveWindow(), MONITOR_DEFAULTTONEAREST);
@@ -182,50 +313,623 @@ static int run_rendering_test(ovRenderer renderer,
 		GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &x, &y);
 		SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
 	}
-	szXml = CreateElement("root", szXml);
-	//	szXml = "<root><option>1061920</option><duration>20</duration><sampleCount>8</sampleCount><maxAnisotropy>0</maxAnisotropy><texturelod>0</texturelod><displaymode>48</displaymode><renderer>12</renderer><pixelformat>1</pixelformat><test>4.2;4.3;4.4;4.5</tet><fbenable>Simple</fbenable><fbformat>RGB</fbformat><scene>0</scene><width>1920</width><height>1080</height></root>";
-	//	szXml = "<root><test>3.0;3.1;3.2;3.3;4.0;4.1;4.2;4.3;4.4;4.5</test><option>0</option><maxAnisotropy>0</maxAnisotropy><sampleCount>0</sampleCount><texturelod>0</texturelod><renderer>12</renderer><pixelformat>1</pixelformat><fbenable>Simple</fbenable><duration>6</duration><scene>0</scene><fbformat>RGB</fbformat><displaymode>72</displaymode></root>";
-	//	szXml = "<root><test>4.2;4.3;4.4;4.5</test><option>0</option><maxAnisotropy>0</maxAnisotropy><sampleCount>8</sampleCount><texturelod>0</texturelod><renderer>12</renderer><pixelformat>1</pixelformat><fbenable>Simple</fbenable><duration>6</duration><scene>0</scene><fbformat>RGB</fbformat><displaymode>72</displaymode><width>1920</width><height>1080</height></root>";
-	//	szXml = "<root><test>3.0;3.1;3.2;3.3;4.0;4.1;4.2;4.3;4.4;4.5</test><option>1048576</option><maxAnisotropy>0</maxAnisotropy><sampleCount>0</sampleCount><texturelod>0</texturelod><renderer>12</renderer><pixelformat>1</pixelformat><fbenable>Simple</fbenable><duration>6</duration><scene>0</scene><fbformat>RGB</fbformat><displaymode>72</displaymode><width>1920</width><height>1080</height></root>";
-	//	szXml = "<root><test>3.0;3.1;3.2;3.3;4.0;4.1;4.2;4.3;4.4;4.5</test><option>1061920</option><maxAnisotropy>0</maxAnisotropy><sampleCount>0</sampleCount><texturelod>0</texturelod><renderer>12</renderer><pixelformat>1</pixelformat><fbenable>Simple</fbenable><duration>6</duration><scene>0</scene><fbformat>RGB</fbformat><displaymode>72</displaymode><width>1920</width><height>1080</height></root>";
-	//	szXml = "<root><option>1061920</option><duration>20</duration><sampleCount>8</sampleCount><maxAnisotropy>0</maxAnisotropy><texturelod>0</texturelod><displaymode>48</displaymode><renderer>12</renderer><pixelformat>1</pixelformat><test>3.0;3.1;3.2;3.3;4.04.1;4.2;4.3;4.4;4.5</test><fbenable>Simple</fbenable><fbformat>RGB</fbformat><scene>0</scene><width>1920</width><height>1080</height></root>";
-	//	szXml = "<root><test>3.0;3.1;3.2;3.3;4.0;4.1;4.2;4.3;4.4;4.5</test><option>1061920</option><maxAnisotropy>0</maxAnisotropy><sampleCount>0</sampleCount><texturelod>0</texturelod><renderer>12</renderer><pixelformat>1</pixelformat><fbenable>Simple</fbenable><duration>6</duration><scene>0</scene><fbformat>RGB</fbformat><displaymode>72</displaymode><width>1920</width><height>1080</height></root>";
-	auto library = LoadLibraryA("infogl.dll");
-	if (library == NULL) {
-		Log.e("Missing DLL infogl.dll");
-		return -1;
+	if (session.funcReadCpuid)
+	{
+		struct gvCpuid processorInfo;
+		session.funcReadCpuid(&processorInfo);
+		Log.v("Starting test %s, %d core(s), %d thread(s)", processorInfo.Specification, processorInfo.Cores, processorInfo.Threads);
+		for (auto& config : configs)
+		{
+			if (config.workerThreads > processorInfo.Threads)
+			{
+				Log.e("%d worker threads on %d hardware threads, CPU times will include preemption", config.workerThreads, processorInfo.Threads);
+				break;
+			}
+		}
 	}
-	auto funcInitWad = (PFNOEVINITWAD)GetProcAddress(library, "oevInitWad");
-	auto funcCpuid = (PFNOEVREADCPUID)GetProcAddress(library, "oevReadCpuid");
-	auto funcRunRenderingTests = (PNFNOEVRUNRENDERINGTESTS)GetProcAddress(library, "oevRunRenderingTests");
-	struct gvCpuid processorInfo;
-	funcCpuid(&processorInfo);
-	Log.v("Starting test %s", processorInfo.Specification);
-	if (funcInitWad("GLVIEW.RMX") >= 0)
+	// infogl.dll groups the configurations sharing a context, see gvRenderingTestResult::configIndex
+	Log.v("Running %d configuration(s)", (int)configs.size());
+	RenderingTestProgress progress;
+	progress.writer = writer;
+	progress.tags = tags;
+	auto job = session.RunAsync(configs.data(), (int)configs.size(), on_rendering_test_result, &progress);
+	if (job == nullptr)
+	{
+		// Older infogl.dll: blocking run
+		auto lpResults = session.Run(configs.data(), (int)configs.size());
+		for (auto lpResult = lpResults; lpResult; lpResult = lpResult->next)
+		{
+			on_rendering_test_result(lpResult, &progress);
+		}
+		session.FreeResults(lpResults);
+		log_wad_stats(session);
+		return 0;
+	}
+	auto status = JOB_RUNNING;
+	auto cancelled = false;
+	while ((status = session.funcJobWait(job, 100)) == JOB_RUNNING)
+	{
+		if (stop_on_failure && !cancelled && progress.failed.load() > 0 && session.funcJobCancel)
+		{
+			session.funcJobCancel(job);
+			cancelled = true;
+		}
+	}
+	Log.v("%d test(s) completed, %d failed%s", progress.completed.load(), progress.failed.load(), cancelled ? ", cancelled" : "");
+	session.funcJobRelease(job);
+	log_wad_stats(session);
+	return status == JOB_FAILED ? -5 : 0;
+}
+/// <summary>
+/// Sessions of the adapters, owned by WinMain. The other adapters get a session on first use,
+/// kept until WinMain returns so that --serve and --listen stay warm
+/// </summary>
+struct AdapterSessions
+{
+	oevSession& primary; // Default adapter
+	int traceFlags; // Same markers as the default session
+	std::map<int, std::unique_ptr<oevSession>> others;
+	// Per adapter and renderer, filled on first use and kept between batches
+	std::map<std::pair<int, int>, std::string> runnableTests;
+	std::map<std::pair<int, int>, std::string> identities; // get_renderer_identity
+	int slot = -1; // Pool worker slot, workers running side by side do not share the capability caches
+
+	AdapterSessions(oevSession& primary, int traceFlags) : primary(primary), traceFlags(traceFlags) {}
+	AdapterSessions(const AdapterSessions&) = delete;
+	AdapterSessions& operator=(const AdapterSessions&) = delete;
+
+	// adapter is gvAdapter::index
+	oevSession& Get(int adapter)
+	{
+		if (adapter == 0)
+		{
+			return primary;
+		}
+		auto& session = others[adapter];
+		if (!session)
+		{
+			session.reset(new oevSession("GLVIEW.RMX", OEV_WAD_MAPPED | OEV_WAD_LAZY, "infogl.dll", traceFlags));
+		}
+		return *session;
+	}
+	// Capability snapshot cache of a renderer, one file per adapter and per worker slot
+	std::string GetCapsCachePath(ovRenderer renderer, int adapter) const
+	{
+		auto path = "glview_caps_" + std::to_string(renderer);
+		if (adapter)
+		{
+			path += "_" + std::to_string(adapter);
+		}
+		if (slot >= 0)
+		{
+			path += "_w" + std::to_string(slot);
+		}
+		return path + ".bin";
+	}
+	// infogl.dll events, moved out of the ring. Every session shares the module, hence the ring
+	std::vector<gvTraceEvent> GetTraceEvents() const
+	{
+		return primary.GetTraceEvents();
+	}
+};
+/// <summary>
+/// Typed configurations of a batch
+/// </summary>
+/// <param name="sessions"></param>
+/// <param name="list">Parsed configurations, owns the tests and cache strings</param>
+/// <param name="adapter">gvAdapter::index, runnable tests are scanned on that adapter</param>
+/// <returns>Configurations without a runnable test or a display mode are dropped</returns>
+static std::vector<gvRenderingTestConfig> create_rendering_test_configs(AdapterSessions& sessions, const std::vector<TestOptions>& list, int adapter)
+{
+	OEV_TRACE_SCOPE("create_rendering_test_configs", "harness", (int)list.size());
+	std::vector<gvRenderingTestConfig> configs;
+	for (auto& options : list)
 	{
-		Log.v("Payload: %s", szXml.c_str());
-		auto lpResult = funcRunRenderingTests(szXml.c_str());
-		while (lpResult)
+		if (LogQueue::Get().IsEnabled(LOG_VERBOSE))
 		{
-			if (!strcmp(lpResult->result, "OK"))
+			Log.d("Configuration %s", FormatTestOptions(options).c_str());
+		}
+		// pipelineCache points into options, like tests below
+		auto config = create_rendering_test_config(options);
+		config.adapter = adapter;
+		if (options.tests.empty())
+		{
+			auto key = std::make_pair(adapter, (int)options.renderer);
+			auto tests = sessions.runnableTests.find(key);
+			if (tests == sessions.runnableTests.end())
 			{
-				Log.v("Test '%d' passed, avg: %g fps.", lpResult->index, lpResult->fps);
+				// Only schedule the tests the renderer and its driver can run
+				// Capabilities are cached on disk and rescanned only when the display driver changes
+				tests = sessions.runnableTests.emplace(key,
+					sessions.Get(adapter).GetRunnableTests(options.renderer, sessions.GetCapsCachePath(options.renderer, adapter).c_str(), 0, adapter)).first;
+				Log.v("Adapter %d renderer %d tests: %s", adapter, options.renderer, tests->second.c_str());
+			}
+			if (tests->second.empty())
+			{
+				Log.e("No runnable test for renderer %d on adapter %d", options.renderer, adapter);
+				continue;
+			}
+			config.tests = tests->second.c_str();
+		}
+		else
+		{
+			config.tests = options.tests.c_str();
+		}
+		if (config.displayMode == OEV_DISPLAYMODE_NOT_FOUND)
+		{
+			Log.e("Display mode %dx%d not supported", config.width, config.height);
+			continue;
+		}
+		configs.push_back(config);
+	}
+	return configs;
+}
+static std::vector<std::string> build_tags(const TagBuilder& tags, const std::vector<gvRenderingTestConfig>& configs)
+{
+	std::vector<std::string> out;
+	for (auto& config : configs)
+	{
+		out.push_back(tags(config));
+	}
+	return out;
+}
+/// <summary>
+/// Run the same configurations on several adapters at once, one session and worker thread per adapter
+/// </summary>
+/// <param name="sessions"></param>
+/// <param name="adapters"></param>
+/// <param name="list">Configurations, the runnable tests are picked per adapter</param>
+/// <param name="writer">Optional, receives the results of all the adapters</param>
+/// <param name="tags">Optional, see ResultWriter::Write</param>
+/// <returns></returns>
+static int run_rendering_tests_on_adapters(AdapterSessions& sessions, const std::vector<gvAdapter>& adapters, const std::vector<TestOptions>& list, ResultWriter* writer,
+	const TagBuilder& tags = nullptr)
+{
+	OEV_TRACE_SCOPE("run_rendering_tests_on_adapters", "harness", (int)adapters.size());
+	struct AdapterRun
+	{
+		const gvAdapter* adapter = nullptr;
+		oevSession* session = nullptr;
+		std::vector<gvRenderingTestConfig> configs;
+		std::vector<std::string> tags;
+		RenderingTestProgress progress;
+		gvRenderingJob* job = nullptr;
+	};
+	std::vector<std::unique_ptr<AdapterRun>> prepared;
+	for (auto& adapter : adapters)
+	{
+		std::unique_ptr<AdapterRun> run(new AdapterRun);
+		run->adapter = &adapter;
+		run->session = &sessions.Get(adapter.index);
+		run->configs = create_rendering_test_configs(sessions, list, adapter.index);
+		if (run->configs.empty())
+		{
+			Log.e("Adapter %d '%s': nothing to run", adapter.index, adapter.name);
+			continue;
+		}
+		if (tags)
+		{
+			// Built per adapter, the results carry the identity of the adapter they ran on
+			run->tags = build_tags(tags, run->configs);
+			run->progress.tags = &run->tags;
+		}
+		run->progress.writer = writer;
+		prepared.push_back(std::move(run));
+	}
+	// Scans are done, they no longer compete with the adapters already running
+	std::vector<std::unique_ptr<AdapterRun>> runs;
+	int ret = 0;
+	for (auto& run : prepared)
+	{
+		auto& adapter = *run->adapter;
+		run->job = run->session->IsValid() ? run->session->RunAsync(run->configs.data(), (int)run->configs.size(), on_rendering_test_result, &run->progress) : nullptr;
+		if (run->job == nullptr)
+		{
+			Log.e("Adapter %d '%s': failed to start rendering tests", adapter.index, adapter.name);
+			ret = -4;
+			continue;
+		}
+		Log.v("Adapter %d '%s': running %d configuration(s)", adapter.index, adapter.name, (int)run->configs.size());
+		runs.push_back(std::move(run));
+	}
+	for (auto& run : runs)
+	{
+		auto status = run->session->funcJobWait(run->job, -1);
+		Log.v("Adapter %d: %d test(s) completed, %d failed", run->configs.front().adapter, run->progress.completed.load(), run->progress.failed.load());
+		run->session->funcJobRelease(run->job);
+		if (status == JOB_FAILED)
+		{
+			ret = -5;
+		}
+	}
+	return runs.empty() && ret == 0 ? -6 : ret;
+}
+/// <summary>
+/// 
+/// </summary>
+/// <param name="sessions"></param>
+/// <param name="list">Parsed configurations, must outlive the run</param>
+/// <param name="all_adapters">Run on every adapter of multi-GPU machines</param>
+/// <param name="writer"></param>
+/// <param name="tags">Optional</param>
+/// <returns>-6 if no configuration can run</returns>
+static int run_batch(AdapterSessions& sessions, const std::vector<TestOptions>& list, bool all_adapters, ResultWriter* writer,
+	const TagBuilder& tags = nullptr)
+{
+	auto& session = sessions.primary;
+	gvAdapter adapters[16];
+	auto adapterCount = session.EnumAdapters(adapters, 16);
+	if (all_adapters && adapterCount > 1)
+	{
+		return run_rendering_tests_on_adapters(sessions,
+			std::vector<gvAdapter>(adapters, adapters + (adapterCount < 16 ? adapterCount : 16)),
+			list, writer, tags);
+	}
+	auto configs = create_rendering_test_configs(sessions, list, 0);
+	if (configs.empty())
+	{
+		return -6;
+	}
+	std::vector<std::string> configTags;
+	if (tags)
+	{
+		configTags = build_tags(tags, configs);
+	}
+	return run_rendering_tests(session, configs, writer, false, tags ? &configTags : nullptr);
+}
+/// <summary>
+/// Stay resident and run the batches read from stdin or a named pipe.
+/// One configuration per line, an empty line or "run" starts the batch, "quit" exits.
+/// The end of each batch is reported as a "batch" event in the results.
+/// </summary>
+/// <param name="sessions"></param>
+/// <param name="commandLine">Defaults of the configurations, pipe name</param>
+/// <param name="writer"></param>
+/// <returns></returns>
+static int serve(AdapterSessions& sessions, const CommandLine& commandLine, ResultWriter* writer)
+{
+	auto pipe = !commandLine.servePipe.empty();
+	auto batch = 0;
+	auto quit = false;
+	while (!quit)
+	{
+		auto input = GetStdHandle(STD_INPUT_HANDLE);
+		if (pipe)
+		{
+			// One client at a time, a new one can connect when it goes away
+			input = CreateNamedPipeA(commandLine.servePipe.c_str(), PIPE_ACCESS_INBOUND, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+				1, 0, 64 * 1024, 0, nullptr);
+			if (input == INVALID_HANDLE_VALUE)
+			{
+				Log.e("Cannot create pipe %s", commandLine.servePipe.c_str());
+				return -9;
+			}
+			if (!ConnectNamedPipe(input, nullptr) && GetLastError() != ERROR_PIPE_CONNECTED)
+			{
+				CloseHandle(input);
+				return -9;
+			}
+		}
+		Log.v("Serving %s", pipe ? commandLine.servePipe.c_str() : "stdin");
+		LineReader reader(input);
+		std::vector<TestOptions> pending;
+		std::string line;
+		auto eof = false;
+		while (!quit && !eof)
+		{
+			eof = !reader.ReadLine(line);
+			auto comment = line.find('#');
+			if (eof || comment != std::string::npos)
+			{
+				line.resize(eof ? 0 : comment);
+			}
+			auto first = line.find_first_not_of(" \t");
+			auto command = first == std::string::npos ? std::string() : line.substr(first, line.find_last_not_of(" \t") - first + 1);
+			quit = command == "quit";
+			if (command.empty() || command == "run" || quit || eof)
+			{
+				if (!pending.empty())
+				{
+					batch++;
+					auto ret = run_batch(sessions, pending, commandLine.allAdapters, writer);
+					pending.clear();
+					if (writer)
+					{
+						writer->WriteEvent("batch", batch, ret);
+						writer->Flush();
+					}
+				}
+				continue;
+			}
+			auto options = commandLine.defaults;
+			std::string error;
+			if (ParseTestOptions(command.c_str(), options, error))
+			{
+				pending.push_back(options);
 			}
 			else
 			{
-				Log.e("Test '%d' failed", lpResult->index);
+				// Skip the line, the rest of the batch still runs
+				Log.e("%s", error.c_str());
+				if (writer)
+				{
+					writer->WriteEvent("invalid", batch + 1, -8);
+				}
 			}
-			lpResult = lpResult->next;
 		}
-		return 0;
+		if (!pipe)
+		{
+			break;
+		}
+		DisconnectNamedPipe(input);
+		CloseHandle(input);
 	}
-	else
+	return 0;
+}
+/// <summary>
+/// Machine identity as JSON members, the same for every result of the agent
+/// </summary>
+/// <param name="session"></param>
+/// <returns>"host", "cpu" and "signature" (gvCpuid::Signature)</returns>
+static std::string get_machine_identity(const oevSession& session)
+{
+	char host[256] = "";
+	DWORD size = sizeof(host);
+	GetComputerNameA(host, &size);
+	std::string json = "\"host\":";
+	ResultWriter::AppendJsonString(json, host);
+	if (session.funcReadCpuid)
 	{
-		Log.e("Missing package GLVIEW.RMX");
-		return -2;
+		struct gvCpuid processorInfo = {};
+		session.funcReadCpuid(&processorInfo);
+		char signature[16];
+		snprintf(signature, sizeof(signature), "%08X", (unsigned)processorInfo.Signature);
+		json += ",\"cpu\":";
+		ResultWriter::AppendJsonString(json, processorInfo.Specification);
+		json += ",\"signature\":";
+		ResultWriter::AppendJsonString(json, signature);
+	}
+	return json;
+}
+/// <summary>
+/// Renderer identity as JSON members, scanned once per adapter and renderer
+/// </summary>
+/// <param name="sessions"></param>
+/// <param name="renderer"></param>
+/// <param name="adapter">gvAdapter::index the results come from</param>
+/// <returns>"renderer", "rendererName", "vendorName" and "driver", null when the adapter cannot be scanned</returns>
+static const std::string& get_renderer_identity(AdapterSessions& sessions, ovRenderer renderer, int adapter)
+{
+	auto& json = sessions.identities[std::make_pair(adapter, (int)renderer)];
+	if (!json.empty())
+	{
+		return json;
+	}
+	const char* name = nullptr;
+	const char* vendor = nullptr;
+	const char* version = nullptr;
+	auto& session = sessions.Get(adapter);
+	// Same cache as GetRunnableTests, otherwise a rescan
+	auto caps = session.GetCapabilities(renderer, sessions.GetCapsCachePath(renderer, adapter).c_str(), 0, adapter);
+	if (caps)
+	{
+		name = session.funcCapsGetRendererName ? session.funcCapsGetRendererName(caps) : nullptr;
+		vendor = session.funcCapsGetVendorName ? session.funcCapsGetVendorName(caps) : nullptr;
+		version = session.funcCapsGetVersion ? session.funcCapsGetVersion(caps) : nullptr;
+	}
+	else if (adapter == 0 && session.funcScanRenderer && session.funcScanRenderer(renderer, 0) >= 0)
+	{
+		// oevScanRenderer only sees the default adapter
+		name = session.funcDiagGetRendererName ? session.funcDiagGetRendererName(renderer) : nullptr;
+		vendor = session.funcDiagGetVendorName ? session.funcDiagGetVendorName(renderer) : nullptr;
+		version = session.funcDiagGetVersion ? session.funcDiagGetVersion(renderer) : nullptr;
 	}
+	json = "\"renderer\":" + std::to_string(renderer) + ",\"rendererName\":";
+	ResultWriter::AppendJsonString(json, name);
+	json += ",\"vendorName\":";
+	ResultWriter::AppendJsonString(json, vendor);
+	json += ",\"driver\":";
+	ResultWriter::AppendJsonString(json, version);
+	if (caps)
+	{
+		session.funcCapsRelease(caps);
+	}
+	return json;
 }
 /// <summary>
+/// Networked benchmark worker, see oevAgent.h
+/// </summary>
+/// <param name="sessions">Warm sessions shared by all the batches</param>
+/// <param name="commandLine">Port, result format and defaults of the configurations</param>
+/// <returns></returns>
+static int run_agent(AdapterSessions& sessions, const CommandLine& commandLine)
+{
+	auto& session = sessions.primary;
+	auto machine = get_machine_identity(session);
+	Agent agent(commandLine.defaults, commandLine.format, "{\"type\":\"agent\",\"protocol\":1," + machine + "}", commandLine.token);
+	if (!agent.Start(commandLine.listenPort, commandLine.bind.c_str()))
+	{
+		return -9;
+	}
+	return agent.Run([&](const std::vector<TestOptions>& batch, ResultWriter* writer)
+	{
+		// Every result carries the machine and the driver it ran on
+		return run_batch(sessions, batch, commandLine.allAdapters, writer, [&](const gvRenderingTestConfig& config)
+		{
+			return machine + "," + get_renderer_identity(sessions, config.renderer, config.adapter);
+		});
+	});
+}
+/// <summary>
+/// Configurations of the command line and of the --config files
+/// </summary>
+/// <param name="commandLine"></param>
+/// <param name="list">Receives the configurations</param>
+/// <returns>false if a configuration file is missing or has a bad line</returns>
+static bool load_test_options(const CommandLine& commandLine, std::vector<TestOptions>& list)
+{
+	std::string error;
+	for (auto& path : commandLine.configFiles)
+	{
+		if (!LoadTestOptions(path.c_str(), commandLine.defaults, list, error))
+		{
+			Log.e("%s", error.c_str());
+			return false;
+		}
+	}
+	if (list.empty() && commandLine.hasOptions)
+	{
+		list.push_back(commandLine.defaults);
+	}
+	if (list.empty())
+	{
+		// @Note: Without arguments, one batch with one configuration per multisampling level
+		for (auto multisampling : { 0, 4, 8 })
+		{
+			list.push_back(commandLine.defaults);
+			list.back().multisampling = multisampling;
+		}
+	}
+	return true;
+}
+/// <summary>
+/// --workers: one job per configuration, run by child processes, see oevPool.h.
+/// This process does not load infogl.dll, a driver crash only takes a worker down.
+/// </summary>
+/// <param name="commandLine"></param>
+/// <returns></returns>
+static int run_pool(const CommandLine& commandLine)
+{
+	std::vector<TestOptions> list;
+	if (!load_test_options(commandLine, list))
+	{
+		return -8;
+	}
+	std::vector<PoolJob> jobs;
+	for (auto& options : list)
+	{
+		// Software rendering only competes for CPU cores, GPU jobs run alone
+		jobs.push_back({ FormatTestOptions(options), options.renderer == RENDERER_GDI });
+	}
+	auto workers = commandLine.workers;
+	if (workers < 0)
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		workers = (int)info.dwNumberOfProcessors;
+	}
+	workers = workers < (int)jobs.size() ? workers : (int)jobs.size();
+	static const char* const formats[] = { "json", "csv", "binary" };
+	static const char* const levels[] = { "verbose", "info", "error", "none" };
+	// Workers log to the debugger only, they would interleave in one --log file
+	auto arguments = std::string("--format ") + formats[(int)commandLine.format] + " --log-level " + levels[commandLine.logLevel] +
+		(commandLine.allAdapters ? "" : " --single-adapter");
+	auto writer = ResultWriter::Open(commandLine.results.c_str(), commandLine.format);
+	if (!writer)
+	{
+		Log.e("Failed to open %s", commandLine.results.c_str());
+	}
+	RunnerPool pool(workers, commandLine.workerTimeout, arguments);
+	if (!pool.Start())
+	{
+		return -3;
+	}
+	return pool.Run(jobs, writer.get());
+}
+/// <summary>
+/// --worker: child process of run_pool, the session stays loaded between jobs
+/// </summary>
+/// <param name="sessions"></param>
+/// <param name="commandLine"></param>
+/// <returns></returns>
+static int run_worker(AdapterSessions& sessions, const CommandLine& commandLine)
+{
+	return RunPoolWorker(commandLine.workerChannel.c_str(), commandLine.format, [&](const std::string& options, int jobId, int slot, ResultWriter* writer)
+	{
+		std::vector<TestOptions> batch(1);
+		std::string error;
+		if (!ParseTestOptions(options.c_str(), batch[0], error))
+		{
+			Log.e("Worker: %s", error.c_str());
+			return -8;
+		}
+		// Per slot capability snapshots, a restarted worker reuses the ones of the worker it replaces
+		sessions.slot = slot;
+		if (!batch[0].cache.empty())
+		{
+			// Workers run side by side, each one keeps its own cache directory warm across restarts
+			batch[0].cache += "_" + std::to_string(slot);
+		}
+		// configIndex is always 0 in a worker, the results carry the pool job id instead
+		writer->SetJob(jobId);
+		return run_batch(sessions, batch, commandLine.allAdapters, writer);
+	});
+}
+/// <summary>
+/// --log path: opened for the lifetime of WinMain, reports the messages lost to a full queue
+/// </summary>
+struct LogOutput
+{
+	HANDLE file = INVALID_HANDLE_VALUE;
+	LogOutput(const CommandLine& commandLine)
+	{
+		auto& queue = LogQueue::Get();
+		queue.SetLevel(commandLine.logLevel);
+		if (commandLine.log.empty())
+		{
+			return;
+		}
+		file = CreateFileA(commandLine.log.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			Log.e("Failed to open log %s", commandLine.log.c_str());
+			return;
+		}
+		queue.SetOutput(file);
+	}
+	~LogOutput()
+	{
+		auto& queue = LogQueue::Get();
+		queue.Flush();
+		if (auto dropped = queue.GetDropped())
+		{
+			Log.e("%llu log message(s) dropped, the queue was full", dropped);
+			queue.Flush();
+		}
+		if (file != INVALID_HANDLE_VALUE)
+		{
+			queue.SetOutput(INVALID_HANDLE_VALUE);
+			CloseHandle(file);
+		}
+	}
+	LogOutput(const LogOutput&) = delete;
+	LogOutput& operator=(const LogOutput&) = delete;
+};
+/// <summary>
+/// --trace path: written when WinMain returns, markers of the harness and of infogl.dll
+/// </summary>
+struct TraceOutput
+{
+	const AdapterSessions& sessions;
+	std::string path;
+	~TraceOutput()
+	{
+		if (path.empty())
+		{
+			return;
+		}
+		auto events = sessions.GetTraceEvents();
+		if (TraceRecorder::Get().WriteChromeTrace(path.c_str(), events))
+		{
+			Log.v("Trace written to %s, %d infogl.dll event(s)", path.c_str(), (int)events.size());
+		}
+		else
+		{
+			Log.e("Failed to write trace %s", path.c_str());
+		}
+	}
+};
+/// <summary>
 /// 
 /// </summary>
 /// <param name="hInstance"></param>
@@ -242,39 +946,74 @@ int PASCAL WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &x, &y);
 		SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
 	}
-	auto library = LoadLibraryA("infogl.dll");
-	if (library == NULL) {
+	// Usage: GLViewApi [key=value ...] [--config file ...] [--serve [\\.\pipe\name]] [--listen port [--bind address] [--token secret]] [--results path] [--format json|csv|binary] [--single-adapter] [--trace [path]] [--workers [N]] [--worker-timeout seconds] [--log path] [--log-level verbose|info|error|none]
+	// key=value tokens describe one configuration, or the defaults of the configuration files and --serve lines
+	CommandLine commandLine;
+	std::string error;
+	if (!ParseCommandLine(lpCmdLine, commandLine, error))
+	{
+		Log.e("Command line: %s", error.c_str());
+		return -8;
+	}
+	LogOutput logOutput(commandLine);
+	if (commandLine.workers && commandLine.workerChannel.empty())
+	{
+		if (commandLine.traceFlags)
+		{
+			// The markers of the workers stay in their processes
+			Log.e("Command line: --trace is not supported with --workers");
+			return -8;
+		}
+		return run_pool(commandLine);
+	}
+	// infogl.dll and GLVIEW.RMX are loaded once and shared by all the runs.
+	// The package is mapped and only the assets of the scenes used get decoded.
+	TraceRecorder::Get().Enable(commandLine.traceFlags);
+	auto loadStart = TraceRecorder::Now();
+	oevSession session("GLVIEW.RMX", OEV_WAD_MAPPED | OEV_WAD_LAZY, "infogl.dll", commandLine.traceFlags);
+	if (!session.IsLoaded()) {
+		Log.e("Missing DLL infogl.dll");
 		return -3;
 	}
-	PFNOEVINITWAD funcInitWad = (PFNOEVINITWAD)GetProcAddress(library, "oevInitWad");
-	PNFNOEVRUNRENDERINGTESTS funcRunRenderingTests = (PNFNOEVRUNRENDERINGTESTS)GetProcAddress(library, "oevRunRenderingTests");
-	if (funcInitWad("GLVIEW.RMX") >= 0)
-	{
-		// @Note: Choose renderer from here
-		//auto renderer = RENDERER_GDI;
-		//auto renderer = RENDERER_GL2_0; 
-		//auto renderer = RENDERER_GL4_6;
-		auto renderer = RENDERER_VK1_2;
-		return run_rendering_test(renderer,
-			FALSE, // Debug
-			FALSE, // fullscreen
-			1920,
-			1080,
-			0, // vsync
-			0, // fog
-			0, // transp
-			0, // user clip plane			
-			"8", // multisampling
-			"16", // maxAnisotropy
-			"0", // texture_LOD
-			"1", // pixel_format
-			"0", // scene
-			"sRGB",  // fbformat : "Linear", "sRGB", "HDR"
-			20 // duration
-		);
+	if (TraceRecorder::IsEnabled())
+	{
+		TraceRecorder::Get().Record("oevSession", "harness", loadStart, TraceRecorder::Now() - loadStart, -1);
+	}
+	// Declared after the sessions: the trace is written while they are still loaded
+	AdapterSessions sessions(session, commandLine.traceFlags);
+	TraceOutput traceOutput{ sessions, commandLine.trace };
+	if (session.IsValid())
+	{
+		log_renderers(session);
+		if (!commandLine.workerChannel.empty())
+		{
+			return run_worker(sessions, commandLine);
+		}
+		if (commandLine.listenPort)
+		{
+			// Results go back to the clients
+			return run_agent(sessions, commandLine);
+		}
+		// Machine readable results, one JSON object per line by default
+		auto writer = ResultWriter::Open(commandLine.results.c_str(), commandLine.format);
+		if (!writer)
+		{
+			Log.e("Failed to open %s", commandLine.results.c_str());
+		}
+		if (commandLine.serve)
+		{
+			return serve(sessions, commandLine, writer.get());
+		}
+		std::vector<TestOptions> list;
+		if (!load_test_options(commandLine, list))
+		{
+			return -8;
+		}
+		return run_batch(sessions, list, commandLine.allAdapters, writer.get());
 	}
 	else
 	{
+		Log.e("Missing package GLVIEW.RMX");
 		return -1;
 	}
 }
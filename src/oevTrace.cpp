@@ -0,0 +1,166 @@
+/****************************************************************************
+; *
+; * 	File		:	oevTrace.cpp
+; *
+; * 	Description :	Scoped trace markers, Chrome trace export
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#include "oevTrace.h"
+#include <TraceLoggingProvider.h>
+#include <stdio.h>
+#include <string>
+#include "oevResultWriter.h"
+
+// {7C1E5B2D-3A94-4F6E-B018-9D2C64A7E35B}
+TRACELOGGING_DEFINE_PROVIDER(g_hTraceProvider, "RealtechVR.GLView.Harness",
+	(0x7c1e5b2d, 0x3a94, 0x4f6e, 0xb0, 0x18, 0x9d, 0x2c, 0x64, 0xa7, 0xe3, 0x5b));
+
+std::atomic<int> TraceRecorder::flags{ 0 };
+
+TraceRecorder& TraceRecorder::Get()
+{
+	static TraceRecorder recorder;
+	return recorder;
+}
+TraceRecorder::TraceRecorder()
+{
+	slots = new Slot[kCapacity];
+	for (size_t i = 0; i < kCapacity; i++)
+	{
+		slots[i].sequence.store(0, std::memory_order_relaxed);
+	}
+}
+TraceRecorder::~TraceRecorder()
+{
+	flags.store(0);
+	if (registered)
+	{
+		TraceLoggingUnregister(g_hTraceProvider);
+	}
+	delete[] slots;
+}
+int TraceRecorder::Enable(int traceFlags)
+{
+	if ((traceFlags & OEV_TRACE_ETW) && !registered)
+	{
+		registered = SUCCEEDED(TraceLoggingRegister(g_hTraceProvider));
+	}
+	return flags.exchange(traceFlags);
+}
+long long TraceRecorder::Now()
+{
+	static const long long frequency = []
+	{
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		return f.QuadPart;
+	}();
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	// Split to avoid overflowing counter * 1000000
+	return counter.QuadPart / frequency * 1000000 + counter.QuadPart % frequency * 1000000 / frequency;
+}
+void TraceRecorder::Record(const char* name, const char* category, long long start, long long duration, int arg)
+{
+	auto current = flags.load(std::memory_order_relaxed);
+	if ((current & OEV_TRACE_ETW) && registered)
+	{
+		TraceLoggingWrite(g_hTraceProvider, "Scope",
+			TraceLoggingString(name, "Name"),
+			TraceLoggingString(category, "Category"),
+			TraceLoggingInt64(start, "Start"),
+			TraceLoggingInt64(duration, "Duration"),
+			TraceLoggingInt32(arg, "Arg"));
+	}
+	if (!(current & OEV_TRACE_RING))
+	{
+		return;
+	}
+	// Writers never wait, a reader detects slots overwritten while it copies them
+	auto pos = position.fetch_add(1, std::memory_order_relaxed);
+	auto& slot = slots[pos & (kCapacity - 1)];
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.event.name = name;
+	slot.event.category = category;
+	slot.event.start = start;
+	slot.event.duration = duration;
+	slot.event.threadId = GetCurrentThreadId();
+	slot.event.arg = arg;
+	slot.sequence.store(pos + 1, std::memory_order_release);
+}
+std::vector<gvTraceEvent> TraceRecorder::GetEvents() const
+{
+	std::vector<gvTraceEvent> events;
+	auto end = position.load(std::memory_order_acquire);
+	auto begin = end > kCapacity ? end - kCapacity : 0;
+	events.reserve(end - begin);
+	for (auto pos = begin; pos < end; pos++)
+	{
+		auto& slot = slots[pos & (kCapacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+		{
+			continue;
+		}
+		auto event = slot.event;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == pos + 1)
+		{
+			events.push_back(event);
+		}
+	}
+	return events;
+}
+static void append_events(std::string& out, const std::vector<gvTraceEvent>& events, DWORD pid, bool& first)
+{
+	char buffer[160];
+	for (auto& event : events)
+	{
+		out += first ? "\n{\"name\":" : ",\n{\"name\":";
+		first = false;
+		ResultWriter::AppendJsonString(out, event.name);
+		out += ",\"cat\":";
+		ResultWriter::AppendJsonString(out, event.category);
+		snprintf(buffer, sizeof(buffer), ",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%lu,\"tid\":%lu",
+			event.start, event.duration, pid, event.threadId);
+		out += buffer;
+		if (event.arg >= 0)
+		{
+			snprintf(buffer, sizeof(buffer), ",\"args\":{\"arg\":%d}", event.arg);
+			out += buffer;
+		}
+		out += '}';
+	}
+}
+bool TraceRecorder::WriteChromeTrace(const char* path, const std::vector<gvTraceEvent>& sdkEvents) const
+{
+	auto events = GetEvents();
+	auto pid = GetCurrentProcessId();
+	std::string out;
+	out.reserve(128 * (events.size() + sdkEvents.size() + 1));
+	out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	auto first = true;
+	append_events(out, events, pid, first);
+	// infogl.dll runs in this process, its categories tell the events apart
+	append_events(out, sdkEvents, pid, first);
+	out += "\n]}\n";
+	auto handle = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	DWORD n = 0;
+	auto ok = WriteFile(handle, out.data(), (DWORD)out.size(), &n, nullptr) && n == out.size();
+	CloseHandle(handle);
+	return ok;
+}
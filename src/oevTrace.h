@@ -0,0 +1,102 @@
+/****************************************************************************
+; *
+; * 	File		:	oevTrace.h
+; *
+; * 	Description :	Scoped trace markers, Chrome trace export
+; *
+; * 	Copyright (C) Realtech VR 2000 - 2022 - https://www.realtech-vr.com/glview
+; *
+; * 	Permission to use, copy, modify, distribute and sell this software
+; * 	and its documentation for any purpose is hereby granted without fee,
+; * 	provided that the above copyright notice appear in all copies and
+; * 	that both that copyright notice and this permission notice appear
+; * 	in supporting documentation.  Realtech VR makes no representations
+; * 	about the suitability of this software for any purpose.
+; * 	It is provided "as is" without express or implied warranty.
+; *
+; ***************************************************************************/
+#pragma once
+#include <atomic>
+#include <vector>
+#include <Windows.h>
+#include "include/oevSDK.h"
+
+/// <summary>
+/// Harness side of the trace: same events and clock as oevTraceEnable, so one
+/// trace shows the phases of infogl.dll and the harness work around them.
+/// Scopes are written to a fixed ring, the oldest are overwritten, and to the
+/// "RealtechVR.GLView.Harness" TraceLogging provider while an ETW session listens.
+/// A disabled scope costs one relaxed atomic load, the clock is not read.
+/// </summary>
+class TraceRecorder
+{
+public:
+	static TraceRecorder& Get();
+
+	static bool IsEnabled() { return flags.load(std::memory_order_relaxed) != 0; }
+	// OEV_TRACE_*, 0 to disable. Returns the previous flags
+	int Enable(int traceFlags);
+	void Record(const char* name, const char* category, long long start, long long duration, int arg);
+	// Microseconds on the QueryPerformanceCounter clock
+	static long long Now();
+	// Events of the ring, oldest first
+	std::vector<gvTraceEvent> GetEvents() const;
+
+	/// <summary>
+	/// Write a Chrome / Perfetto trace, "X" events of the ring and of infogl.dll
+	/// </summary>
+	/// <param name="path"></param>
+	/// <param name="sdkEvents">oevSession::GetTraceEvents</param>
+	/// <returns>false if the file cannot be written</returns>
+	bool WriteChromeTrace(const char* path, const std::vector<gvTraceEvent>& sdkEvents) const;
+
+	~TraceRecorder();
+
+private:
+	TraceRecorder();
+	TraceRecorder(const TraceRecorder&) = delete;
+	TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+	static const size_t kCapacity = 65536; // Power of two
+	struct Slot
+	{
+		std::atomic<size_t> sequence; // Position + 1 once written, 0 while being written
+		gvTraceEvent event;
+	};
+	static std::atomic<int> flags;
+	Slot* slots;
+	std::atomic<size_t> position{ 0 };
+	bool registered = false; // ETW provider
+};
+
+class TraceScope
+{
+public:
+	TraceScope(const char* name, const char* category, int arg = -1) :
+		name(name),
+		category(category),
+		arg(arg),
+		start(TraceRecorder::IsEnabled() ? TraceRecorder::Now() : -1)
+	{
+	}
+	~TraceScope()
+	{
+		if (start >= 0)
+		{
+			TraceRecorder::Get().Record(name, category, start, TraceRecorder::Now() - start, arg);
+		}
+	}
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* name; // Static strings, only the pointers are recorded
+	const char* category;
+	int arg;
+	long long start;
+};
+
+#define OEV_TRACE_JOIN2(a, b) a##b
+#define OEV_TRACE_JOIN(a, b) OEV_TRACE_JOIN2(a, b)
+// Scope until the end of the block, name and category must be string literals
+#define OEV_TRACE_SCOPE(name, ...) TraceScope OEV_TRACE_JOIN(traceScope, __LINE__)(name, __VA_ARGS__)